@@ -0,0 +1,141 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+/*
+ * End-to-end throughput benchmark.
+ * Starts the mock API server in-process, points discord-rm at it and runs a full removal.
+ */
+
+#include <bench/mock_server.hpp>
+#include <include/config.hpp>
+#include <include/remover.hpp>
+#include <include/job.hpp>
+#include <include/options.hpp>
+#include <include/logger.hpp>
+#include <argparse/argparse.hpp>
+#include <fmt/base.h>
+#include <fmt/color.h>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <string>
+#include <utility>
+#include <vector>
+
+int main(const int argc, char** argv) {
+    argparse::ArgumentParser program("discord-rm-bench", "1.5");
+    program.add_argument("--messages").help("Seeded messages").scan<'u', unsigned int>().default_value(1000u);
+    program.add_argument("--channels").help("Spread the messages over this many channels of one guild (guild-wide run if more than 1)").scan<'u', unsigned int>().default_value(1u);
+    program.add_argument("--manage-messages").help("Allow bulk delete in the guild channels").default_value(false).implicit_value(true);
+    program.add_argument("--interval").help("Seconds between two seeded messages").scan<'u', unsigned int>().default_value(60u);
+    program.add_argument("--jobs").help("Run one job per channel side by side, as a `--jobs` manifest would, instead of one guild-wide job").default_value(false).implicit_value(true);
+    program.add_argument("--sequential").help("With `--jobs`, run the jobs one after another, like separate processes").default_value(false).implicit_value(true);
+    program.add_argument("--import").help("Read the messages from a data package written by the mock instead of searching").default_value(false).implicit_value(true);
+    program.add_argument("--keep-every").help("Every Nth message has a link embed and is kept").scan<'u', unsigned int>().default_value(0u);
+    program.add_argument("--attachment-every").help("Every Nth message has image and video attachments").scan<'u', unsigned int>().default_value(0u);
+    program.add_argument("--bucket-limit").help("Requests per rate limit window").scan<'u', unsigned int>().default_value(50u);
+    program.add_argument("--bucket-window").help("Rate limit window in milliseconds").scan<'u', unsigned int>().default_value(1000u);
+    program.add_argument("--latency").help("Server latency in milliseconds").scan<'u', unsigned int>().default_value(0u);
+    program.add_argument("--index-delay").help("Deleted messages stay searchable this many milliseconds").scan<'u', unsigned int>().default_value(0u);
+    program.add_argument("--storm-every").help("Start a global 429 storm every N milliseconds").scan<'u', unsigned int>().default_value(0u);
+    program.add_argument("--storm-length").help("Length of a 429 storm in milliseconds").scan<'u', unsigned int>().default_value(0u);
+    program.add_argument("--error-rate").help("Share of requests answered with 502").scan<'g', double>().default_value(0.0);
+    program.add_argument("--seed").help("Random seed").scan<'u', unsigned int>().default_value(1u);
+    program.add_argument("-v", "--verbose").help("Verbose discord-rm output").default_value(false).implicit_value(true);
+
+    try {
+        program.parse_args(argc, argv);
+
+        MockConfig config;
+        config.messages = program.get<unsigned int>("--messages");
+        config.channels = program.get<unsigned int>("--channels");
+        config.interval_s = program.get<unsigned int>("--interval");
+        config.keep_every = program.get<unsigned int>("--keep-every");
+        config.manage_messages = program.get<bool>("--manage-messages");
+        config.attachment_every = program.get<unsigned int>("--attachment-every");
+        config.bucket_limit = program.get<unsigned int>("--bucket-limit");
+        config.bucket_window_ms = program.get<unsigned int>("--bucket-window");
+        config.latency_ms = program.get<unsigned int>("--latency");
+        config.index_delay_ms = program.get<unsigned int>("--index-delay");
+        config.storm_every_ms = program.get<unsigned int>("--storm-every");
+        config.storm_length_ms = program.get<unsigned int>("--storm-length");
+        config.server_error_rate = program.get<double>("--error-rate");
+        config.seed = program.get<unsigned int>("--seed");
+
+        MockServer server(config);
+        server.start();
+
+        SENDER_ID            = "1";
+        // Bulk delete only exists in guilds, so it needs a guild run too
+        const bool is_guild  = config.channels > 1 || config.manage_messages;
+        GUILD_ID             = is_guild ? "1" : "@me";
+        CHANNEL_ID           = config.channels > 1 ? "" : "1000";
+        IS_NOCONFIRM         = true;
+        IS_SKIP_IF_FAIL      = true; // Injected 5xx errors must not end the run
+        IS_BULK_DELETE       = true; // Used where the mock allows it (`--manage-messages`)
+        NO_LINK              = config.keep_every > 0;
+
+        const auto package = std::filesystem::temp_directory_path() / "discord-rm-bench-package";
+        if (program.get<bool>("--import")) {
+            std::filesystem::remove_all(package);
+            server.write_data_package(package.string(), GUILD_ID);
+            IMPORT_PATH = package.string();
+        }
+
+        std::vector<JobConfig> jobs;
+        if (program.get<bool>("--jobs")) {
+            for (unsigned int c = 0; c < config.channels; ++c) {
+                CHANNEL_ID = std::to_string(1000 + c);
+                jobs.push_back(job_from_options());
+            }
+        } else {
+            jobs.push_back(job_from_options());
+        }
+
+        const auto started = std::chrono::steady_clock::now();
+        std::chrono::nanoseconds rate_limit_wait{};
+        uint64_t retries = 0;
+        const auto run = [&](const std::vector<JobConfig>& run_jobs) {
+            RemoverConfig settings; // No progress, only the results are printed
+            settings.jobs    = run_jobs;
+            settings.token   = "benchmark";
+            settings.api_url = server.url();
+            settings.log_level = program.get<bool>("--verbose") ? LogLevel::VERBOSE : LogLevel::INFO;
+            const RunStats run_stats = Remover(std::move(settings)).run();
+            rate_limit_wait += run_stats.rate_limit_wait;
+            retries += run_stats.retries;
+        };
+        if (program.get<bool>("--sequential")) {
+            for (const JobConfig& job : jobs) run({job});
+        } else {
+            run(jobs);
+        }
+        const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - started;
+
+        const auto& stats = server.stats();
+        const std::chrono::duration<double> waited = rate_limit_wait;
+        server.stop();
+        if (!IMPORT_PATH.empty()) std::filesystem::remove_all(package);
+
+        fmt::print("Elapsed:              {:.3f} s\n", elapsed.count());
+        fmt::print("Messages deleted:     {} ({} left on server)\n", stats.deleted.load(), server.remaining());
+        fmt::print("Deleted per second:   {:.2f}\n", static_cast<double>(stats.deleted) / elapsed.count());
+        fmt::print("Total requests:       {} ({} searches, {} deletes, {} bulk deletes)\n",
+                   stats.requests.load(), stats.searches.load(), stats.deletes.load(), stats.bulk_deletes.load());
+        fmt::print("Wasted requests:      {} (429: {}, 5xx: {}, 404: {})\n",
+                   stats.wasted(), stats.rate_limited.load(), stats.server_errors.load(), stats.not_found.load());
+        fmt::print("Rate limit wait:      {:.3f} s\n", waited.count());
+        fmt::print("Retried requests:     {}\n", retries);
+        fmt::print("Bytes received:       {}\n", stats.bytes_sent.load());
+        return 0;
+    } catch (const std::exception& ex) {
+        fmt::print(fg(fmt::color::red), "ERROR: {}\n", ex.what());
+        return 1;
+    }
+}
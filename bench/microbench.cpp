@@ -0,0 +1,241 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+/*
+ * Microbenchmarks for the helpers and the page parse-and-filter step.
+ * Reports nanoseconds and heap allocations per operation. The previous, stream-based helpers are kept
+ * here as `reference` so the replacements can be compared against them on every machine.
+ */
+
+#include <include/helpers.hpp>
+#include <include/message.hpp>
+#include <include/filter.hpp>
+#include <include/config.hpp>
+#include <include/job.hpp>
+#include <include/options.hpp>
+#include <argparse/argparse.hpp>
+#include <fmt/base.h>
+#include <fmt/format.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <ctime>
+#include <iomanip>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace {
+    std::atomic<uint64_t> ALLOCATIONS = 0;
+}
+
+// Every heap allocation of the process is counted
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete" // `free` pairs with the `malloc` below, GCC only sees the inlined calls
+#endif
+void* operator new(const std::size_t size) {
+    ALLOCATIONS.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+    // The helpers as they were before the allocation-free versions.
+    namespace reference {
+        std::string url_encode(const std::string& value) {
+            std::ostringstream escaped;
+
+            escaped.fill('0');
+            escaped << std::hex;
+
+            for (char c : value) {
+                if (isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.' || c == '~') {
+                    escaped << c;
+                    continue;
+                }
+
+                escaped << '%' << std::setw(2) << static_cast<int>(static_cast<unsigned char>(c));
+            }
+            return escaped.str();
+        }
+
+        std::string build_query_string(const std::vector<Query>& params) {
+            std::ostringstream oss;
+            bool first = true;
+            for (const auto& [key, value] : params) {
+                if (!value.empty()) {
+                    if (!first) oss << "&";
+                    oss << url_encode(key) << "=" << url_encode(value);
+                    first = false;
+                }
+            }
+            return oss.str();
+        }
+
+        std::vector<Query> construct_query_params() {
+            std::vector<Query> params = {
+                {"author_id", SENDER_ID},
+                {"channel_id", CHANNEL_ID},
+                {"limit", std::to_string(PAGE_LIMIT)},
+                {"sort_by", "timestamp"},
+                {"sort_order", "desc"}
+            };
+
+            if (!MENTIONS.empty()) {
+                for (const auto& mention : MENTIONS) params.emplace_back("mentions", mention);
+            }
+
+            if (!REMOVE_PINNED) params.emplace_back("pinned", "false");
+
+            return params;
+        }
+
+        std::string convert_to_snowflake_id(const std::string& iso8601) {
+            std::tm tm = {};
+            std::istringstream ss(iso8601);
+
+            ss >> std::get_time(&tm, "%Y-%m-%d");
+            if (ss.fail()) throw std::runtime_error("Failed to parse ISO8601 date");
+            tm.tm_isdst = -1;
+
+            const std::time_t time = std::mktime(&tm);
+            if (time == -1) throw std::runtime_error("Failed to parse ISO8601 date");
+
+            const auto time_point = std::chrono::system_clock::from_time_t(time);
+            const auto ms_since_epoch = std::chrono::duration_cast<std::chrono::milliseconds>(time_point.time_since_epoch()).count();
+            const unsigned long long int timestamp = ms_since_epoch - DISCORD_EPOCH;
+            const unsigned long long int snowflake = timestamp << 22;
+
+            return std::to_string(snowflake);
+        }
+    }
+
+    template <typename T>
+    void keep(const T& value) {
+        asm volatile("" : : "r,m"(value) : "memory"); // The result counts as used, so the call is not optimized out
+    }
+
+    struct Options {
+        std::chrono::milliseconds min_time;
+        std::string filter;
+    };
+
+    template <typename F>
+    void run(const Options& options, const std::string& name, F&& operation) {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos) return;
+
+        for (int i = 0; i < 16; ++i) operation(); // Warm up caches and buffers
+
+        using clock = std::chrono::steady_clock;
+        uint64_t iterations = 0, batch = 1;
+        const uint64_t allocations_before = ALLOCATIONS.load(std::memory_order_relaxed);
+        const auto start = clock::now();
+        auto now = start;
+
+        while (now - start < options.min_time) {
+            for (uint64_t i = 0; i < batch; ++i) operation();
+            iterations += batch;
+            batch = std::min<uint64_t>(batch * 2, 1 << 16);
+            now = clock::now();
+        }
+
+        const double ns = std::chrono::duration<double, std::nano>(now - start).count() / static_cast<double>(iterations);
+        const double allocations = static_cast<double>(ALLOCATIONS.load(std::memory_order_relaxed) - allocations_before) / static_cast<double>(iterations);
+        fmt::print("{:<44} {:>12.1f} ns/op {:>10.2f} allocs/op\n", name, ns, allocations);
+    }
+
+    // A search response in Discord's shape, with the fields the parser has to skip.
+    std::string search_page(const unsigned int messages, const size_t content_length) {
+        std::string page = R"({"total_results": 5000, "messages": [)";
+        for (unsigned int i = 0; i < messages; ++i) {
+            if (i) page += ',';
+            const uint64_t id = 1200000000000000000ULL + i * 4194304000ULL;
+            const bool has_attachment = i % 5 == 0, has_embed = i % 7 == 0;
+
+            page += fmt::format(R"([{{"id": "{}", "type": 0, "content": "{}", "channel_id": "1000", )", id, std::string(content_length, 'x'));
+            page += R"("author": {"id": "1", "username": "bench", "avatar": null, "discriminator": "0", "public_flags": 0, "global_name": "Bench"}, )";
+            page += R"("pinned": false, "mentions": [], "mention_roles": [], "mention_everyone": false, "tts": false, )";
+            page += R"("timestamp": "2024-01-01T00:00:00.000000+00:00", "edited_timestamp": null, "flags": 0, "components": [], )";
+            page += has_attachment
+                ? R"("attachments": [{"id": "1", "filename": "a.png", "size": 1024, "url": "https://cdn.discordapp.com/a.png", "content_type": "image/png"}], )"
+                : R"("attachments": [], )";
+            page += has_embed ? R"("embeds": [{"type": "link", "url": "https://example.com"}], "hit": true}])" : R"("embeds": [], "hit": true}])";
+        }
+        return page + "]}";
+    }
+}
+
+int main(const int argc, char** argv) {
+    argparse::ArgumentParser program("discord-rm-microbench", "1.5");
+    program.add_argument("--min-time").help("Milliseconds to run each benchmark for").scan<'u', unsigned int>().default_value(300u);
+    program.add_argument("--filter").help("Only run benchmarks whose name contains this").default_value(std::string());
+
+    try {
+        program.parse_args(argc, argv);
+    } catch (const std::exception& e) {
+        fmt::print("{}\n", e.what());
+        return 1;
+    }
+
+    const Options options{std::chrono::milliseconds(program.get<unsigned int>("--min-time")), program.get<std::string>("--filter")};
+
+    SENDER_ID = "123456789012345678";
+    CHANNEL_ID = "987654321098765432";
+    MENTIONS = {"111111111111111111", "222222222222222222"};
+    REMOVE_PINNED = false;
+    const JobConfig job = job_from_options();
+
+    const std::string plain = "123456789012345678", mixed = "user name/with ?special=&chars+ünïcödé";
+    run(options, "url_encode/plain (reference)", [&] { keep(reference::url_encode(plain)); });
+    run(options, "url_encode/plain", [&] { keep(url_encode(plain)); });
+    run(options, "url_encode/mixed (reference)", [&] { keep(reference::url_encode(mixed)); });
+    run(options, "url_encode/mixed", [&] { keep(url_encode(mixed)); });
+
+    std::string buffer;
+    buffer.reserve(256);
+    run(options, "url_encode/mixed, appended", [&] {
+        buffer.clear();
+        url_encode(buffer, mixed);
+        keep(buffer);
+    });
+
+    run(options, "search query (reference)", [&] { keep(reference::build_query_string(reference::construct_query_params())); });
+    run(options, "search query", [&] { keep(build_search_query(job)); });
+
+    const std::string date = "2021-06-15T12:00:00";
+    run(options, "convert_to_snowflake_id (reference)", [&] { keep(reference::convert_to_snowflake_id(date)); });
+    run(options, "convert_to_snowflake_id", [&] { keep(convert_to_snowflake_id(date)); });
+    run(options, "date_to_snowflake", [&] { keep(date_to_snowflake(date)); });
+    if (reference::convert_to_snowflake_id(date) != convert_to_snowflake_id(date))
+        fmt::print("Mismatch: convert_to_snowflake_id differs from the reference!\n");
+
+    // Parse and filter, as the search stage does for every page
+    NO_LINK = true;
+    NO_IMAGE = true;
+    const FeatureSet rules = compile_filter();
+    SearchPage page;
+    for (const auto& [messages, content] : {std::pair{1u, size_t{32}}, {25u, size_t{32}}, {25u, size_t{2000}}}) {
+        const std::string body = search_page(messages, content);
+        for (const bool keep_content : {false, true}) {
+            run(options, fmt::format("parse+filter/{} messages, {} B content{}", messages, content, keep_content ? ", kept" : ""), [&] {
+                parse_search_page(body, page, keep_content);
+                size_t queued = 0;
+                for (const auto& m : page.messages) queued += !is_excluded(m.features, rules);
+                keep(queued);
+            });
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,443 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <bench/mock_server.hpp>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using nlohmann::json;
+
+namespace {
+    constexpr uint64_t DISCORD_EPOCH = 1420070400000ULL;
+    constexpr int POLL_INTERVAL_MS = 100;
+    const std::string API_PREFIX = "/api/v10/";
+
+    uint64_t to_number(const std::string_view s) {
+        uint64_t value = 0;
+        std::from_chars(s.data(), s.data() + s.size(), value);
+        return value;
+    }
+
+    std::string_view reason(const int status) {
+        switch (status) {
+            case 200: return "OK";
+            case 204: return "No Content";
+            case 404: return "Not Found";
+            case 429: return "Too Many Requests";
+            case 502: return "Bad Gateway";
+            default:  return "Unknown";
+        }
+    }
+
+    // Splits "a/b/c" into its segments.
+    std::vector<std::string_view> split_path(std::string_view path) {
+        std::vector<std::string_view> segments;
+        while (!path.empty()) {
+            const auto slash = path.find('/');
+            segments.push_back(path.substr(0, slash));
+            if (slash == std::string_view::npos) break;
+            path.remove_prefix(slash + 1);
+        }
+        return segments;
+    }
+
+    std::string seconds(const std::chrono::steady_clock::duration d) {
+        return std::to_string(std::max(0.0, std::chrono::duration<double>(d).count()));
+    }
+}
+
+MockServer::MockServer(MockConfig config) : config(config), random(config.seed) {
+    seed();
+}
+
+MockServer::~MockServer() {
+    stop();
+}
+
+void MockServer::seed() {
+    const auto now_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+
+    for (unsigned int i = 0; i < config.messages; ++i) {
+        // One message per interval going back in time, newest first
+        const uint64_t id = ((now_ms - DISCORD_EPOCH - i * config.interval_s * 1000ULL) << 22) | (i & 0xFFF);
+        const uint64_t channel_id = 1000 + i % std::max(config.channels, 1u);
+
+        json m = {
+            {"id", std::to_string(id)},
+            {"type", 0},
+            {"content", "Benchmark message " + std::to_string(i)},
+            {"channel_id", std::to_string(channel_id)},
+            {"author", {{"id", "1"}, {"username", "bench"}}},
+            {"attachments", json::array()},
+            {"embeds", json::array()},
+            {"pinned", false}
+        };
+        if (config.keep_every && i % config.keep_every == 0)
+            m["embeds"].push_back({{"type", "link"}, {"url", "https://example.com"}});
+        if (config.attachment_every && i % config.attachment_every == 1) {
+            m["attachments"].push_back({{"id", "1"}, {"filename", "a.png"}, {"content_type", "image/png"}});
+            m["attachments"].push_back({{"id", "2"}, {"filename", "b.mp4"}, {"content_type", "video/mp4"}});
+        }
+
+        store.emplace(id, StoredMessage{channel_id, m.dump()});
+    }
+}
+
+std::string MockServer::url() const {
+    return "http://127.0.0.1:" + std::to_string(bound_port) + "/api/";
+}
+
+size_t MockServer::remaining() {
+    std::scoped_lock lock(mutex);
+    return std::ranges::count_if(store, [](const auto& entry) { return !entry.second.deleted; });
+}
+
+void MockServer::write_data_package(const std::string& root, const std::string& guild_id) {
+    std::scoped_lock lock(mutex);
+    const std::filesystem::path messages = std::filesystem::path(root) / "messages";
+    std::map<uint64_t, json> channels; // Channel ID -> exported messages
+
+    for (const auto& [id, m] : store) {
+        const json message = json::parse(m.json);
+        std::string attachments;
+        for (const auto& attachment : message["attachments"]) {
+            if (!attachments.empty()) attachments += ' ';
+            attachments += "https://cdn.discordapp.com/attachments/" + std::to_string(m.channel_id) + "/1/"
+                           + attachment["filename"].get<std::string>();
+        }
+
+        std::string contents = message["content"];
+        if (!message["embeds"].empty()) contents += " https://example.com"; // Unfurled into the link embed
+        channels[m.channel_id].push_back({{"ID", id}, {"Timestamp", ""}, {"Contents", contents}, {"Attachments", attachments}});
+    }
+
+    json index = json::object();
+    for (const auto& [channel_id, exported] : channels) {
+        const auto folder = messages / ("c" + std::to_string(channel_id));
+        std::filesystem::create_directories(folder);
+        std::ofstream(folder / "channel.json") << json{{"id", std::to_string(channel_id)}, {"type", 0}, {"guild", {{"id", guild_id}, {"name", "bench"}}}}.dump();
+        std::ofstream(folder / "messages.json") << exported.dump();
+        index[std::to_string(channel_id)] = "bench-" + std::to_string(channel_id);
+    }
+    std::ofstream(messages / "index.json") << index.dump();
+}
+
+void MockServer::start() {
+    listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (listen_fd < 0) throw std::runtime_error("Mock server: failed to create socket.");
+
+    constexpr int yes = 1;
+    setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    if (bind(listen_fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0 || listen(listen_fd, 64) < 0)
+        throw std::runtime_error("Mock server: failed to bind.");
+
+    socklen_t length = sizeof(addr);
+    getsockname(listen_fd, reinterpret_cast<sockaddr*>(&addr), &length);
+    bound_port = ntohs(addr.sin_port);
+
+    started = clock::now();
+    running = true;
+    acceptor = std::thread([this] { accept_loop(); });
+}
+
+void MockServer::stop() {
+    if (!running.exchange(false)) return;
+
+    acceptor.join();
+    close(listen_fd);
+
+    std::scoped_lock lock(connections_mutex);
+    for (const int fd : connection_fds) shutdown(fd, SHUT_RDWR);
+    for (auto& t : connections) t.join();
+    connections.clear();
+    connection_fds.clear();
+}
+
+void MockServer::accept_loop() {
+    while (running) {
+        pollfd p{listen_fd, POLLIN, 0};
+        if (poll(&p, 1, POLL_INTERVAL_MS) <= 0) continue;
+
+        const int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd < 0) continue;
+
+        constexpr int yes = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+
+        std::scoped_lock lock(connections_mutex);
+        connection_fds.push_back(fd);
+        connections.emplace_back([this, fd] { serve(fd); });
+    }
+}
+
+void MockServer::serve(const int fd) {
+    std::string buffer;
+    char chunk[16384];
+
+    // Returns false once the client has closed the connection
+    const auto receive = [&] {
+        pollfd p{fd, POLLIN, 0};
+        if (poll(&p, 1, POLL_INTERVAL_MS) <= 0) return true;
+        const ssize_t n = recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk, n);
+        return true;
+    };
+
+    while (running) {
+        const auto header_end = buffer.find("\r\n\r\n");
+        if (header_end == std::string::npos) {
+            if (!receive()) break;
+            continue;
+        }
+
+        // Request line: METHOD TARGET HTTP/1.1
+        const std::string_view head(buffer.data(), header_end);
+        const auto first_space = head.find(' ');
+        const auto second_space = head.find(' ', first_space + 1);
+        const std::string method(head.substr(0, first_space));
+        const std::string target(head.substr(first_space + 1, second_space - first_space - 1));
+
+        size_t body_length = 0;
+        if (const auto cl = head.find("Content-Length: "); cl != std::string_view::npos)
+            body_length = to_number(head.substr(cl + 16, head.find("\r\n", cl) - cl - 16));
+        if (buffer.size() < header_end + 4 + body_length) {
+            if (!receive()) break;
+            continue;
+        }
+        const std::string body = buffer.substr(header_end + 4, body_length);
+        buffer.erase(0, header_end + 4 + body_length);
+
+        if (config.latency_ms) std::this_thread::sleep_for(std::chrono::milliseconds(config.latency_ms));
+
+        const HttpResponse response = handle(method, target, body);
+        std::string out = "HTTP/1.1 " + std::to_string(response.status) + ' ' + std::string(reason(response.status)) + "\r\n";
+        out += "Content-Type: application/json\r\nContent-Length: " + std::to_string(response.body.size()) + "\r\n";
+        for (const auto& [name, value] : response.headers) out += name + ": " + value + "\r\n";
+        out += "\r\n";
+        out += response.body;
+
+        counters.bytes_sent += out.size();
+        for (size_t sent = 0; sent < out.size();) {
+            const ssize_t n = send(fd, out.data() + sent, out.size() - sent, MSG_NOSIGNAL);
+            if (n <= 0) break;
+            sent += n;
+        }
+    }
+    close(fd);
+}
+
+MockServer::HttpResponse MockServer::handle(const std::string& method, const std::string& target, const std::string_view body) {
+    ++counters.requests;
+    std::scoped_lock lock(mutex);
+    HttpResponse response;
+
+    // A storm is a window in which everything is globally rate limited
+    if (config.storm_every_ms) {
+        const auto phase = std::chrono::duration_cast<std::chrono::milliseconds>(clock::now() - started).count() % config.storm_every_ms;
+        if (static_cast<unsigned int>(phase) < config.storm_length_ms) {
+            const double retry_after = (config.storm_length_ms - phase) / 1000.0;
+            ++counters.rate_limited;
+            response.status = 429;
+            response.body = json{{"message", "You are being rate limited."}, {"retry_after", retry_after}, {"global", true}}.dump();
+            response.headers = {{"Retry-After", std::to_string(static_cast<int>(std::ceil(retry_after)))}, {"X-RateLimit-Global", "true"}};
+            return response;
+        }
+    }
+
+    if (config.server_error_rate > 0 && std::uniform_real_distribution<>(0, 1)(random) < config.server_error_rate) {
+        ++counters.server_errors;
+        response.status = 502;
+        response.body = R"({"message": "Bad Gateway"})";
+        return response;
+    }
+
+    const auto query_start = target.find('?');
+    const std::string path = target.substr(0, query_start);
+    const std::string query = query_start == std::string::npos ? "" : target.substr(query_start + 1);
+
+    if (!path.starts_with(API_PREFIX)) {
+        response.status = 404;
+        return response;
+    }
+
+    const auto segments = split_path(std::string_view(path).substr(API_PREFIX.size()));
+    // guilds|channels / {id} / messages / search
+    if (method == "GET" && segments.size() == 4 && segments[2] == "messages" && segments[3] == "search") {
+        ++counters.searches;
+        if (!take_token("search:" + std::string(segments[1]), response)) return response;
+        auto result = search(path, query);
+        result.headers.insert(result.headers.end(), response.headers.begin(), response.headers.end());
+        return result;
+    }
+    // channels / {id} / messages / bulk-delete
+    if (method == "POST" && segments.size() == 4 && segments[0] == "channels" && segments[3] == "bulk-delete") {
+        ++counters.bulk_deletes;
+        if (!take_token("bulk:" + std::string(segments[1]), response)) return response;
+        auto result = bulk_remove(to_number(segments[1]), body);
+        result.headers.insert(result.headers.end(), response.headers.begin(), response.headers.end());
+        return result;
+    }
+    // channels / {id} / messages / {id}
+    if (method == "DELETE" && segments.size() == 4 && segments[0] == "channels" && segments[2] == "messages") {
+        ++counters.deletes;
+        if (!take_token("delete:" + std::string(segments[1]), response)) return response;
+        auto result = remove(to_number(segments[1]), to_number(segments[3]));
+        result.headers.insert(result.headers.end(), response.headers.begin(), response.headers.end());
+        return result;
+    }
+
+    response.status = 404;
+    response.body = R"({"message": "404: Not Found", "code": 0})";
+    return response;
+}
+
+bool MockServer::take_token(const std::string& bucket_name, HttpResponse& response) {
+    const auto now = clock::now();
+    Bucket& bucket = buckets[bucket_name];
+    const auto hash = std::to_string(std::hash<std::string>{}(bucket_name.substr(0, bucket_name.find(':'))));
+
+    if (now >= bucket.reset_at) {
+        bucket.remaining = config.bucket_limit;
+        bucket.reset_at = now + std::chrono::milliseconds(config.bucket_window_ms);
+    }
+
+    if (bucket.remaining == 0) {
+        const double retry_after = std::chrono::duration<double>(bucket.reset_at - now).count();
+        ++counters.rate_limited;
+        response.status = 429;
+        response.body = json{{"message", "You are being rate limited."}, {"retry_after", retry_after}, {"global", false}}.dump();
+        response.headers = {{"Retry-After", std::to_string(static_cast<int>(std::ceil(retry_after)))},
+                            {"X-RateLimit-Bucket", hash},
+                            {"X-RateLimit-Limit", std::to_string(config.bucket_limit)},
+                            {"X-RateLimit-Remaining", "0"},
+                            {"X-RateLimit-Reset-After", seconds(bucket.reset_at - now)},
+                            {"X-RateLimit-Scope", "user"}};
+        return false;
+    }
+
+    --bucket.remaining;
+    response.headers = {{"X-RateLimit-Bucket", hash},
+                        {"X-RateLimit-Limit", std::to_string(config.bucket_limit)},
+                        {"X-RateLimit-Remaining", std::to_string(bucket.remaining)},
+                        {"X-RateLimit-Reset-After", seconds(bucket.reset_at - now)}};
+    return true;
+}
+
+bool MockServer::visible(const StoredMessage& m, const clock::time_point now) const {
+    // The search index forgets deleted messages only after a delay
+    return !m.deleted || now - m.deleted_at < std::chrono::milliseconds(config.index_delay_ms);
+}
+
+MockServer::HttpResponse MockServer::search(const std::string& path, const std::string& query) {
+    const auto now = clock::now();
+    uint64_t channel_filter = 0, min_id = 0, max_id = UINT64_MAX;
+    unsigned int offset = 0, limit = 25;
+
+    // Parameters may repeat (e.g. two `min_id`), the tightest bound wins
+    std::string_view rest(query);
+    while (!rest.empty()) {
+        const auto amp = rest.find('&');
+        const auto pair = rest.substr(0, amp);
+        const auto eq = pair.find('=');
+        const auto key = pair.substr(0, eq), value = eq == std::string_view::npos ? std::string_view() : pair.substr(eq + 1);
+
+        if (key == "channel_id") channel_filter = to_number(value);
+        else if (key == "offset") offset = static_cast<unsigned int>(to_number(value));
+        else if (key == "limit") limit = static_cast<unsigned int>(to_number(value));
+        else if (key == "min_id") min_id = std::max(min_id, to_number(value));
+        else if (key == "max_id") max_id = std::min(max_id, to_number(value));
+
+        if (amp == std::string_view::npos) break;
+        rest.remove_prefix(amp + 1);
+    }
+
+    const auto segments = split_path(std::string_view(path).substr(API_PREFIX.size()));
+    if (segments[0] == "channels") channel_filter = to_number(segments[1]);
+
+    std::string page;
+    unsigned int total = 0, returned = 0;
+    for (const auto& [id, m] : store) {
+        if (id >= max_id || id <= min_id) continue;
+        if (channel_filter && m.channel_id != channel_filter) continue;
+        if (!visible(m, now)) continue;
+
+        if (total >= offset && returned < limit) {
+            if (returned++) page += ',';
+            page += '[' + m.json + ']';
+        }
+        ++total;
+    }
+
+    return {200, R"({"total_results": )" + std::to_string(total) + R"(, "messages": [)" + page + "]}", {}};
+}
+
+MockServer::HttpResponse MockServer::remove(const uint64_t channel_id, const uint64_t message_id) {
+    const auto it = store.find(message_id);
+    if (it == store.end() || it->second.deleted || it->second.channel_id != channel_id) {
+        ++counters.not_found;
+        return {404, R"({"message": "Unknown Message", "code": 10008})", {}};
+    }
+
+    it->second.deleted = true;
+    it->second.deleted_at = clock::now();
+    ++counters.deleted;
+    return {204, "", {}};
+}
+
+MockServer::HttpResponse MockServer::bulk_remove(const uint64_t channel_id, const std::string_view body) {
+    constexpr auto MAX_AGE = std::chrono::days(14);
+
+    if (!config.manage_messages)
+        return {403, R"({"message": "Missing Permissions", "code": 50013})", {}};
+
+    const json request = json::parse(body, nullptr, false);
+    if (request.is_discarded() || !request.contains("messages") || !request["messages"].is_array()
+        || request["messages"].size() < 2 || request["messages"].size() > 100)
+        return {400, R"({"message": "You must provide at least 2 and fewer than 100 messages to delete.", "code": 50016})", {}};
+
+    const auto now_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    std::vector<uint64_t> ids;
+    for (const auto& id : request["messages"]) {
+        ids.push_back(to_number(id.get<std::string>()));
+        if ((ids.back() >> 22) + DISCORD_EPOCH + std::chrono::milliseconds(MAX_AGE).count() < now_ms)
+            return {400, R"({"message": "You can only bulk delete messages that are under 14 days old.", "code": 50034})", {}};
+    }
+
+    // Unknown messages are ignored, like the real endpoint does
+    for (const uint64_t id : ids) {
+        const auto it = store.find(id);
+        if (it == store.end() || it->second.deleted || it->second.channel_id != channel_id) continue;
+        it->second.deleted = true;
+        it->second.deleted_at = clock::now();
+        ++counters.deleted;
+    }
+    return {204, "", {}};
+}
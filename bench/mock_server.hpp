@@ -0,0 +1,128 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/*
+ * Local stand-in for the parts of the Discord API used by discord-rm:
+ *   GET    /api/v10/guilds/{id}/messages/search
+ *   GET    /api/v10/channels/{id}/messages/search
+ *   DELETE /api/v10/channels/{id}/messages/{id}
+ *   POST   /api/v10/channels/{id}/messages/bulk-delete
+ *
+ * Plain HTTP/1.1 with keep-alive, one thread per connection. POSIX only.
+ */
+struct MockConfig {
+    unsigned int messages = 1000;             // Seeded messages
+    unsigned int channels = 1;                // Messages are spread over this many channels
+    unsigned int interval_s = 60;             // Age difference between two consecutive messages
+    unsigned int keep_every = 0;              // Every Nth message has a link embed (0 = none)
+    unsigned int attachment_every = 0;        // Every Nth message has an image and a video attachment (0 = none)
+    bool manage_messages = false;             // Bulk delete is allowed, otherwise it is answered with 403
+    unsigned int bucket_limit = 5;            // Requests per bucket window
+    unsigned int bucket_window_ms = 1000;
+    unsigned int latency_ms = 0;              // Added to every response
+    unsigned int index_delay_ms = 0;          // Deleted messages stay in search results this long
+    unsigned int storm_every_ms = 0;          // Every N ms all requests get a global 429 ... (0 = never)
+    unsigned int storm_length_ms = 0;         // ... for this long
+    double server_error_rate = 0;             // Share of requests answered with a 5xx
+    unsigned int seed = 1;
+};
+
+struct MockStats {
+    std::atomic<uint64_t> requests = 0;
+    std::atomic<uint64_t> searches = 0;
+    std::atomic<uint64_t> deletes = 0;
+    std::atomic<uint64_t> bulk_deletes = 0;
+    std::atomic<uint64_t> deleted = 0;
+    std::atomic<uint64_t> rate_limited = 0;  // 429
+    std::atomic<uint64_t> server_errors = 0; // 5xx
+    std::atomic<uint64_t> not_found = 0;     // DELETE of a message that no longer exists
+    std::atomic<uint64_t> bytes_sent = 0;
+
+    uint64_t wasted() const { return rate_limited + server_errors + not_found; }
+};
+
+class MockServer {
+public:
+    explicit MockServer(MockConfig config);
+    ~MockServer();
+
+    MockServer(const MockServer&) = delete;
+    MockServer& operator=(const MockServer&) = delete;
+
+    // Binds to 127.0.0.1 on a free port and starts serving.
+    void start();
+    void stop();
+
+    unsigned short port() const { return bound_port; }
+    std::string url() const; // API base URL, e.g. "http://127.0.0.1:1234/api/"
+    const MockStats& stats() const { return counters; }
+    size_t remaining(); // Messages that still exist
+
+    // Writes the seeded messages as the `messages` folder of a data package, see `read_data_package`.
+    void write_data_package(const std::string& root, const std::string& guild_id);
+
+private:
+    using clock = std::chrono::steady_clock;
+
+    struct StoredMessage {
+        uint64_t channel_id;
+        std::string json;
+        clock::time_point deleted_at{}; // Zero while the message exists
+        bool deleted = false;
+    };
+
+    struct HttpResponse {
+        int status = 200;
+        std::string body;
+        std::vector<std::pair<std::string, std::string>> headers;
+    };
+
+    struct Bucket {
+        unsigned int remaining = 0;
+        clock::time_point reset_at{};
+    };
+
+    void seed();
+    void accept_loop();
+    void serve(int fd);
+    HttpResponse handle(const std::string& method, const std::string& target, std::string_view body);
+    HttpResponse search(const std::string& path, const std::string& query);
+    HttpResponse remove(uint64_t channel_id, uint64_t message_id);
+    HttpResponse bulk_remove(uint64_t channel_id, std::string_view body);
+    bool take_token(const std::string& bucket, HttpResponse& response);
+    bool visible(const StoredMessage& m, clock::time_point now) const;
+
+    MockConfig config;
+    MockStats counters;
+    std::mutex mutex;
+    std::map<uint64_t, StoredMessage, std::greater<>> store; // Newest first, like search results
+    std::map<std::string, Bucket> buckets;
+    std::mt19937 random;
+    clock::time_point started{};
+    std::atomic<bool> running = false;
+    int listen_fd = -1;
+    unsigned short bound_port = 0;
+    std::thread acceptor;
+    std::mutex connections_mutex;
+    std::vector<std::thread> connections;
+    std::vector<int> connection_fds;
+};
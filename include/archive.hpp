@@ -0,0 +1,71 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+
+/*
+ * Archive of the deleted messages (`--archive`): their JSON as returned by the search, one per line,
+ * in a gzip file that is only ever appended to, so `zcat archive.gz` reads all of it.
+ *
+ * Messages are compressed and written by a background thread. `add` only copies the record into a buffer
+ * of at most `BUFFER_LIMIT` bytes, and waits only while the buffer is full. The delete stage calls `wait`
+ * before a message is deleted, which returns at once unless the writer is behind.
+ *
+ * The file is a series of gzip members of up to `MEMBER_SIZE` bytes of records each. Every member is
+ * complete on its own, so a member can be decompressed without the ones before it. `<path>.idx` has a line
+ * "<message id> <offset of its member>" per record, see `find_archived`.
+ */
+class ArchiveWriter {
+public:
+    static constexpr size_t BUFFER_LIMIT = 8 * 1024 * 1024;
+    static constexpr size_t MEMBER_SIZE = 64 * 1024;
+
+    explicit ArchiveWriter(const std::string& path);
+    ~ArchiveWriter(); // Writes what is still buffered
+
+    ArchiveWriter(const ArchiveWriter&) = delete;
+    ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+    // Queues the record of a message and returns its sequence number, for `wait`. Thread-safe.
+    uint64_t add(uint64_t id, std::string json);
+
+    // Blocks until the record `sequence` and all before it are written. Throws if the archive cannot be written.
+    void wait(uint64_t sequence);
+
+private:
+    void run();
+    void write_member(const std::string& records, const std::string& index);
+
+    std::ofstream file;
+    std::ofstream index_file;
+    uint64_t offset = 0; // Size of the archive, where the next member starts
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<std::pair<uint64_t, std::string>> pending;
+    size_t pending_bytes = 0;
+    uint64_t added = 0, written = 0;
+    std::exception_ptr error; // Of the writer thread
+    bool is_stopping = false;
+    std::thread thread; // Last, so it starts once everything above is constructed
+};
+
+// The archived record of the message, read from `<path>.idx` and one member of `path`. The last one wins if it was archived twice.
+std::optional<std::string> find_archived(const std::string& path, uint64_t id);
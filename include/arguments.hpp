@@ -8,8 +8,25 @@
 
 #pragma once
 
+#include <include/helpers.hpp>
 #include <argparse/argparse.hpp>
+#include <fmt/base.h>
+#include <iostream>
+#include <string>
+#include <string_view>
 using namespace argparse;
 
+// Prompts of the command line, the library never reads from stdin.
+inline bool parse_input(const std::string_view& in) { return format_string(in) == "y" || in == "Y"; }
+
+inline void ask(const std::string_view& question, std::string& save) {
+    fmt::print("{}", question);
+    std::cin >> save;
+}
+
+inline void input(const std::string_view& msg, std::string& save) {
+    ask(msg, save);
+}
+
 ArgumentParser& create_arguments();
 void process_arguments(ArgumentParser& p, int argc, char** argv);
@@ -0,0 +1,85 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <include/client.hpp>
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/*
+ * HTTP exchanges of a run on disk (`--record`, `--replay`), for running the same session again without the network,
+ * e.g. to compare the CPU time and requests of two builds. Every run has a cassette of its own, used by its clients and transport.
+ *
+ * `<dir>/exchanges.jsonl` has one line per request: method, URL (relative to the API base), request body,
+ * and the response with its status, headers, body, transfer time and size. The token is never written,
+ * and neither are cookies.
+ *
+ * Replayed requests are matched by method, URL and body; repeated requests get the recorded responses in order.
+ * Some requests depend on thread timing and differ between runs of the same session: bulk delete batches
+ * may be cut differently, so a miss falls back to the next exchange with the same method and URL; time shards
+ * may be split differently (see `ShardQueue`), so a search that was not recorded is answered from the results
+ * of all recorded searches with the same parameters. Any other request that was never recorded gets a 404.
+ * At recorded speed every response takes as long as it did; fast replay takes no time and clears the waits
+ * asked for by the rate limit headers.
+ */
+class Cassette {
+public:
+    static constexpr const char* FILE_NAME = "exchanges.jsonl";
+
+    // Starts writing the exchanges of the run to `dir`, replacing an earlier recording. URLs are kept relative to `api_url`.
+    void record_to(const std::string& dir, const std::string& api_url);
+    // Loads the exchanges of `dir`. From now on no request goes to the network.
+    void replay_from(const std::string& dir, const std::string& api_url, bool is_fast);
+
+    bool is_recording() const { return mode == Mode::RECORD; }
+    bool is_replaying() const { return mode == Mode::REPLAY; }
+    bool is_fast() const { return fast; }
+
+    // Thread-safe.
+    void record(std::string_view method, std::string_view url, std::string_view body, const Response& response);
+    // The recorded response to the request. Thread-safe.
+    Response replay(std::string_view method, std::string_view url, std::string_view body);
+
+    uint64_t replayed() const { return replayed_count; }
+    uint64_t searched() const { return searched_count; } // Searches answered from the recorded results
+    uint64_t missed() const { return missed_count; }     // Not in the recording
+
+private:
+    enum class Mode { OFF, RECORD, REPLAY };
+
+    struct Exchange {
+        std::string body;
+        Response response;
+    };
+
+    struct Hit {
+        uint64_t id = 0;
+        std::string group; // The result and its context messages, as recorded
+    };
+
+    std::string_view relative_url(std::string_view url) const;
+    std::string route_key(std::string_view method, std::string_view url) const;
+    void add_hits(const std::string& search, const std::string& body);
+    bool search(const std::string& search, uint64_t min_id, uint64_t max_id, Response& response);
+
+    Mode mode = Mode::OFF;
+    bool fast = false;
+    std::string api_url;
+    std::mutex mutex;
+    std::ofstream out;
+    std::unordered_map<std::string, std::deque<Exchange>> exchanges; // By "<method> <url>", in recorded order
+    std::unordered_map<std::string, std::vector<Hit>> hits; // By search URL without its range, newest first
+    uint64_t replayed_count = 0, searched_count = 0, missed_count = 0;
+};
@@ -0,0 +1,155 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <curl/curl.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <initializer_list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class Cassette;
+
+struct Response {
+    CURLcode result = CURLE_OK;
+    long http_code = 0;
+    std::string body;
+    std::vector<std::pair<std::string, std::string>> headers; // Names are lowercase
+    std::chrono::microseconds elapsed{}; // From the start of the request to the last byte of the response
+    uint64_t bytes = 0;                  // Sent and received, headers included
+
+    // Returns an empty view if the header is missing.
+    std::string_view header(std::string_view name) const;
+};
+
+/*
+ * DNS cache, TLS sessions and open connections, shared by the clients and transports of one or more runs
+ * (see `RemoverConfig::connections`). Thread-safe.
+ *
+ * Clients share all three. A transport's multi handle keeps its connections to itself, as libcurl only
+ * polls them from the thread of the transport, but it takes DNS entries and TLS sessions from the pool,
+ * so a new connection resumes a session instead of a full handshake.
+ */
+class ConnectionPool {
+public:
+    ConnectionPool();
+    ~ConnectionPool();
+
+    ConnectionPool(const ConnectionPool&) = delete;
+    ConnectionPool& operator=(const ConnectionPool&) = delete;
+
+    CURLSH* clients() const { return client_share.handle; }
+    CURLSH* transfers() const { return transfer_share.handle; }
+
+private:
+    struct Share {
+        CURLSH* handle = nullptr;
+        std::array<std::mutex, CURL_LOCK_DATA_LAST> locks;
+    };
+
+    static void init(Share& share, std::initializer_list<curl_lock_data> data);
+
+    Share client_share;   // DNS, TLS sessions and connections
+    Share transfer_share; // DNS and TLS sessions
+};
+
+/*
+ * Reusable HTTP client.
+ * Owns one easy handle for its whole lifetime, so libcurl keeps the connection alive between requests.
+ * Clients of the same pool share the DNS cache, TLS sessions and connections.
+ * The authorization header list is built once, on construction.
+ * Requests are recorded or replayed by `cassette` when it is on.
+ * Transfers time out when they stall, and are aborted (`CURLE_ABORTED_BY_CALLBACK`) once `cancelled` is set.
+ */
+class Client {
+public:
+    Client(const std::string& token, ConnectionPool& pool, Cassette& cassette, const std::atomic<bool>& cancelled);
+    ~Client();
+
+    Client(const Client&) = delete;
+    Client& operator=(const Client&) = delete;
+
+    // The returned response is owned by the client and is overwritten by the next request.
+    // A non-empty `body` is sent as JSON.
+    const Response& request(const std::string& url, const std::string& method, std::string_view body = {});
+
+private:
+    CURL* curl = nullptr;
+    curl_slist* headers = nullptr;
+    Cassette& cassette;
+    Response response;
+};
+
+/*
+ * Event loop over a curl multi handle, for keeping several requests in flight from one thread.
+ * Requests to the same host are multiplexed over one HTTP/2 connection where the server supports it,
+ * and spread over up to `MAX_CONNECTIONS` HTTP/1.1 connections where it does not.
+ * Easy handles and their buffers are pooled and reused, like `Client`'s. Polled from one thread, one per run.
+ * Timeouts and `cancelled` work as in `Client`.
+ */
+class Transport {
+public:
+    using Callback = std::function<void(const Response&)>;
+
+    static constexpr long MAX_CONNECTIONS = 8;
+
+    Transport(const std::string& token, ConnectionPool& pool, Cassette& cassette, const std::atomic<bool>& cancelled);
+    ~Transport();
+
+    Transport(const Transport&) = delete;
+    Transport& operator=(const Transport&) = delete;
+
+    // Starts a request. `on_done` is called from `poll` once it has finished. A non-empty `body` is sent as JSON.
+    void submit(const std::string& url, const std::string& method, std::string_view body, Callback on_done);
+
+    // Moves the transfers forward, waiting at most `timeout` for network activity, and runs the callbacks of finished requests.
+    // An exception thrown by a callback is passed on; the other transfers stay in flight.
+    void poll(std::chrono::milliseconds timeout);
+
+    // Thread-safe. Makes a waiting (or the next) `poll` return early, e.g. when there is new work to submit.
+    void wakeup();
+
+    size_t in_flight() const { return active.size() + replays.size(); }
+
+private:
+    struct Transfer {
+        CURL* curl = nullptr;
+        Response response;
+        Callback on_done;
+        std::string method, url, body; // Only kept while recording
+    };
+
+    // A response from the cassette, handed out once it is due.
+    struct Replay {
+        std::chrono::steady_clock::time_point due;
+        Response response;
+        Callback on_done;
+    };
+
+    void poll_replays(std::chrono::milliseconds timeout);
+
+    CURLM* multi = nullptr;
+    curl_slist* headers = nullptr;
+    ConnectionPool& pool;
+    Cassette& cassette;
+    const std::atomic<bool>& cancelled;
+    std::vector<std::unique_ptr<Transfer>> idle;
+    std::unordered_map<CURL*, std::unique_ptr<Transfer>> active;
+    std::vector<Replay> replays;
+};
@@ -10,6 +10,7 @@
 #include <string>
 #include <vector>
 
+extern std::string                        DISCORD_API_URL_BASE;
 extern unsigned int                       DELAY_IN_MS;
 extern unsigned int                       DISPLAY_LENGTH;
 extern std::string                        DISCORD_TOKEN;
@@ -18,6 +19,7 @@ extern bool                               IS_DEBUG;
 extern bool                               IS_NOCONFIRM;
 extern bool                               IS_INTERACTIVE;
 extern bool                               IS_SKIP_IF_FAIL;
+extern bool                               IS_PROGRESS;
 extern std::string                        SENDER_ID;
 extern std::string                        GUILD_ID;
 extern std::string                        CHANNEL_ID;
@@ -27,6 +29,19 @@ extern std::string                        BEFORE_DATE;
 extern std::string                        DURING_DATE;
 extern std::string                        AFTER_DATE;
 extern bool                               IS_DISPLAY;
+extern std::string                        JOURNAL_PATH;
+extern bool                               IS_RESUME;
+extern bool                               IS_BULK_DELETE;
+extern std::string                        IMPORT_PATH;
+extern std::string                        PLAN_PATH;
+extern std::string                        EXECUTE_PLAN_PATH;
+extern std::string                        METRICS_PATH;
+extern std::string                        ARCHIVE_PATH;
+extern std::string                        ARCHIVE_FIND;
+extern std::string                        RECORD_PATH;
+extern std::string                        REPLAY_PATH;
+extern bool                               IS_REPLAY_FAST;
+extern std::string                        JOBS_PATH;
 extern bool                               REMOVE_PINNED;
 extern bool                               NO_LINK;
 extern bool                               NO_EMBED;
@@ -37,5 +52,9 @@ extern bool                               NO_IMAGE;
 extern bool                               NO_SOUND;
 extern bool                               NO_STICKER;
 extern bool                               NO_FORWARD;
-constexpr unsigned int                    DELAY_IN_MS_DEFAULT     = 1000;
+constexpr const char*                     DISCORD_API_URL_BASE_DEFAULT = "https://discord.com/api/";
+constexpr unsigned int                    DELAY_IN_MS_DEFAULT     = 0; // Rate limits are taken from the response headers
 constexpr unsigned short                  PAGE_LIMIT              = 25;
+constexpr unsigned short                  QUEUE_LIMIT             = PAGE_LIMIT * 2; // Messages waiting for deletion
+constexpr unsigned short                  MAX_IN_FLIGHT           = 8; // Delete requests sent concurrently
+constexpr unsigned short                  SEARCH_WORKERS          = 4; // Time shards of a job searched concurrently
@@ -0,0 +1,43 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+
+/*
+ * Every message is classified into a set of features while its search result is parsed,
+ * covering all of its attachments and embeds. The `--no-*` options are compiled into a
+ * rule mask of the same features once per run (see `compile_filter`), so keeping a message is a single mask test.
+ */
+using FeatureSet = uint16_t;
+
+enum Feature : FeatureSet {
+    FEATURE_SYSTEM  = 1 << 0, // Cannot be deleted, always excluded
+    FEATURE_POLL    = 1 << 1,
+    FEATURE_EMBED   = 1 << 2,
+    FEATURE_LINK    = 1 << 3, // Embed of type `link`
+    FEATURE_FILE    = 1 << 4, // Attachment without a content type
+    FEATURE_IMAGE   = 1 << 5,
+    FEATURE_VIDEO   = 1 << 6,
+    FEATURE_AUDIO   = 1 << 7,
+    FEATURE_STICKER = 1 << 8,
+    FEATURE_FORWARD = 1 << 9
+};
+
+// Feature excluded by the `--no-<name>` option, e.g. "link". Returns 0 if there is no such option.
+FeatureSet option_feature(std::string_view name);
+
+FeatureSet classify_attachment(std::string_view content_type);
+FeatureSet classify_embed(std::string_view type);
+
+// Data packages only have the attachment URL, so the file extension stands in for the content type.
+FeatureSet classify_attachment_url(std::string_view url);
+
+inline bool is_excluded(const FeatureSet features, const FeatureSet rules) { return (features & rules) != 0; }
@@ -9,24 +9,24 @@
 #pragma once
 
 #include <nlohmann/json.hpp>
-#include <curl/curl.h>
-#include <fmt/base.h>
-#include <fmt/color.h>
 #include <utility>
 #include <string>
 #include <string_view>
 #include <algorithm>
 #include <cctype>
-#include <iostream>
 #include <vector>
-#include <thread>
+#include <cstdint>
 
 using Query = std::pair<std::string, std::string>;
 
-enum MessageType {
-    OK,
-    WARNING,
-    ERROR
+struct JobConfig;
+
+// Discord uses its own timestamp system instead of the traditional Unix timestamps
+constexpr uint64_t DISCORD_EPOCH = 1420070400000ULL;
+
+struct SnowflakeRange { // Exclusive bounds, as `min_id`/`max_id` of the search
+    uint64_t min_id = 0;
+    uint64_t max_id = UINT64_MAX;
 };
 
 inline std::string format_string(const std::string_view& s) {
@@ -39,54 +39,26 @@ inline std::string format_string(const std::string_view& s) {
 }
 
 inline bool is_dm_guild(const std::string_view& guild_id) { return guild_id == "@me"; }
-inline bool parse_input(const std::string_view& in) { return format_string(in) == "y" || in == "Y"; }
-
-inline void ask(const std::string_view& question, std::string& save) {
-    fmt::print("{}", question);
-    std::cin >> save;
-}
-
-inline void input(const std::string_view& msg, std::string& save) {
-    ask(msg, save);
-}
-
-inline void log(const bool is_verbose, const std::string_view& msg, const MessageType type = OK) {
-    if (!is_verbose)
-        return;
-
-    switch (type) {
-        case OK:
-            fmt::print("{}\n", msg);
-            break;
-        case WARNING:
-            fmt::print(fg(fmt::color::yellow), "{}\n", msg);
-            break;
-        case ERROR:
-            fmt::print(fg(fmt::color::red), "{}\n", msg);
-            break;
-    }
-}
 
-inline void debug(const bool is_debug, const std::string_view& msg, const MessageType type = OK) { // Rename for `log` function
-    log(is_debug, msg, type);
-}
+// Unix time in milliseconds at which the snowflake was created.
+inline uint64_t snowflake_time_ms(const uint64_t id) { return (id >> 22) + DISCORD_EPOCH; }
 
 inline bool is_system_message(const int type) { return (type < 6 || type > 21) && type != 0; }
 inline bool is_http_error(const long code) { return code < 200 || code >= 300; }
 
-inline void handle_rate_limit(nlohmann::json response) {
-    constexpr unsigned int DELAY_MULTIPLIER = 2;
-
-    const auto new_delay = static_cast<unsigned int>(response["retry_after"].get<double>());
-    std::this_thread::sleep_for(std::chrono::seconds(new_delay * DELAY_MULTIPLIER)); // Wait a little longer to ensure not hit rate limit again
-}
-
 size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp);
+// Appends `value` percent-encoded to `out`.
+void url_encode(std::string& out, std::string_view value);
 std::string url_encode(const std::string& value);
+
+// Appends `key=value` to a query string, encoded and separated by '&'. Parameters without a value are left out.
+void append_query(std::string& query, std::string_view key, std::string_view value);
 std::string build_query_string(const std::vector<Query>& params);
+
+// Snowflake of local midnight on an ISO 8601 date (YYYY-MM-DD, a time after it is ignored).
+uint64_t date_to_snowflake(std::string_view iso8601);
 std::string convert_to_snowflake_id(const std::string& iso8601);
-std::vector<Query> construct_query_params(const std::string& offset);
-std::pair<CURL*, CURLcode> send_request(std::string& response,
-                                        const std::string& _headers,
-                                        const std::string& url,
-                                        const std::string& method);
+
+// Query of the search endpoint, built once per job.
+std::string build_search_query(const JobConfig& job);
+SnowflakeRange search_range(const JobConfig& job);
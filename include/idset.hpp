@@ -0,0 +1,68 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Set of snowflake IDs in one flat open-addressed table (linear probing).
+ * 0 marks an empty slot, which is never a valid snowflake.
+ * With the load kept between 0.4 and 0.8, a tracked ID costs 10-20 bytes and no allocation of its own.
+ */
+class IdSet {
+public:
+    // Returns false if the ID was already in the set.
+    bool insert(const uint64_t id) {
+        if ((count + 1) * 5 > slots.size() * 4) grow();
+
+        size_t i = index_of(id);
+        while (slots[i] != 0) {
+            if (slots[i] == id) return false;
+            i = (i + 1) & (slots.size() - 1);
+        }
+        slots[i] = id;
+        ++count;
+        return true;
+    }
+
+    bool contains(const uint64_t id) const {
+        if (slots.empty()) return false;
+
+        for (size_t i = index_of(id); slots[i] != 0; i = (i + 1) & (slots.size() - 1))
+            if (slots[i] == id) return true;
+        return false;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    static constexpr size_t INITIAL_CAPACITY = 1024;
+
+    size_t index_of(uint64_t id) const {
+        // The low bits of a snowflake (worker, sequence) are mostly zero, so mix before masking
+        id ^= id >> 33;
+        id *= 0xff51afd7ed558ccdULL;
+        id ^= id >> 33;
+        return static_cast<size_t>(id) & (slots.size() - 1);
+    }
+
+    void grow() {
+        std::vector<uint64_t> old(slots.empty() ? INITIAL_CAPACITY : slots.size() * 2, 0);
+        old.swap(slots);
+        count = 0;
+        for (const uint64_t id : old)
+            if (id != 0) insert(id);
+    }
+
+    std::vector<uint64_t> slots; // Size is a power of two
+    size_t count = 0;
+};
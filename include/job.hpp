@@ -0,0 +1,62 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <include/filter.hpp>
+#include <string>
+#include <vector>
+
+/*
+ * Settings of one cleanup job: what to delete and where its journal or plan goes.
+ * Built before the run starts and only read afterwards, so several jobs can run side by side in one process.
+ * Settings of the whole run (token, API URL, delay, output, metrics) are in `RemoverConfig`.
+ */
+struct JobConfig {
+    std::string name;       // Shown in the summary
+    std::string guild_id;
+    std::string channel_id; // Empty for the whole guild
+    std::string sender_id;
+    std::vector<std::string> mentions;
+    std::string before_date; // Snowflakes of the date options, empty if not given
+    std::string during_date;
+    std::string after_date;
+    FeatureSet rules = FEATURE_SYSTEM; // Excluded features, see `compile_filter`
+    bool remove_pinned = true;
+    bool bulk_delete = false; // Opt-in (`--bulk`): without Manage Messages, the first batch of every channel is refused
+    bool skip_if_fail = false;
+    std::string journal_path;
+    bool resume = false;
+    std::string import_path;
+    std::string plan_path;
+    std::string execute_plan_path;
+};
+
+/*
+ * The journal and plan header of the job: "<guild id> <channel id> <sender id>", then the settings that decide
+ * which messages are deleted: "<before> <during> <after> <excluded features> <remove pinned> <mentions>".
+ * A journal can only be resumed with the same header.
+ */
+std::string run_header(const JobConfig& job);
+
+// Name of a job that has none: its guild, and its channel if it has one.
+std::string default_job_name(const JobConfig& job);
+
+/*
+ * Reads a job manifest (`--jobs`), a JSON array with one object per job:
+ *
+ *   [
+ *     { "name": "memes", "guild-id": "123", "channel-id": "456", "no-link": true },
+ *     { "guild-id": "@me", "channel-id": "789", "before-date": "2023-01-01", "journal": "dm.journal" }
+ *   ]
+ *
+ * Keys are the long names of the per-job command line options, which also give the defaults:
+ * `sender-id`, `guild-id`, `channel-id`, `mentions`, the date options, `journal`, `resume`, `import`,
+ * `plan`, `execute-plan`, `skip-if-fail`, `bulk` and the `no-*` filters.
+ */
+std::vector<JobConfig> read_job_manifest(const std::string& path, const JobConfig& defaults);
@@ -0,0 +1,69 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <include/idset.hpp>
+#include <include/helpers.hpp>
+
+/*
+ * Append-only checkpoint journal, one record per line:
+ *
+ *   H <guild id> <channel id> <sender id>   run header, followed by the filter and date settings (see `run_header`)
+ *   P <max_id> <min_id>                     a search page found every message between the two IDs (exclusive),
+ *                                           written once all of them are queued or skipped
+ *   Q <message id>                          queued for deletion
+ *   S <message id>                          skipped by the filters
+ *   D <message id>                          deleted
+ *   F <message id> <reason>                 deletion failed, its page is searched again on resume
+ *
+ * Records are buffered and written in batches. A torn last line is ignored when resuming.
+ */
+class Journal {
+public:
+    struct State {
+        std::vector<SnowflakeRange> searched; // Pages whose messages are all done, not searched again
+        IdSet done;                           // Deleted or skipped, not processed again
+        std::vector<uint64_t> deleted;        // Seed the tombstones of the run, see `Tombstones`
+    };
+
+    // Starts a new journal, or with `resume` reads the state of an existing one and appends to it.
+    // `header` identifies the run (see `run_header`), a journal of another run cannot be resumed.
+    Journal(const std::string& path, bool resume, std::string header);
+    ~Journal();
+
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    const State& state() const { return resumed; }
+
+    void page(const SnowflakeRange& searched);
+    void queued(uint64_t id);
+    void skipped(uint64_t id);
+    void deleted(uint64_t id);
+    void failed(uint64_t id, std::string_view reason);
+    void flush();
+
+private:
+    void read(const std::string& path);
+    void append(char kind, uint64_t value, std::string_view extra = {});
+    void write_pending();
+
+    std::mutex mutex;
+    std::ofstream file;
+    std::string pending;
+    unsigned int pending_records = 0;
+    std::string header;
+    State resumed;
+};
@@ -0,0 +1,114 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <fmt/format.h>
+#include <functional>
+#include <optional>
+#include <string>
+#include <utility>
+
+enum MessageType {
+    OK,
+    WARNING,
+    ERROR
+};
+
+/*
+ * Log levels, from the most detailed: `DEBUG` is shown with `--debug`, `VERBOSE` with `--verbose`, `INFO` always.
+ *
+ * Messages are fmt format strings, formatted only when their level is enabled, so a disabled call
+ * neither formats nor allocates. Calls below `DISCORD_RM_MIN_LOG_LEVEL` are removed at compile time
+ * (release builds set it to 1, which strips `debug`).
+ *
+ * Enabled lines are written by a sink thread, so a slow terminal or a redirected log file does not
+ * hold up the requests. `flush_log` waits for it before printing anything directly.
+ * The sink also keeps the status line of a terminal (see `ProgressReporter`) below the log lines.
+ * Lines go to stdout, or to the handler of `set_log_handler` when a program embeds the library.
+ *
+ * The level is per thread: the threads of a run log at `RemoverConfig::log_level` (see `LogLevelScope`),
+ * so runs with different levels can share a process. Other threads use the level of `set_log_level`.
+ */
+enum class LogLevel { DEBUG = 0, VERBOSE = 1, INFO = 2 };
+
+#ifndef DISCORD_RM_MIN_LOG_LEVEL
+#define DISCORD_RM_MIN_LOG_LEVEL 0
+#endif
+
+using LogHandler = std::function<void(MessageType, const std::string&)>;
+
+// Level of the threads that have no `LogLevelScope`, `INFO` until it is changed.
+void set_log_level(LogLevel level);
+
+// Most detailed level the calling thread logs.
+LogLevel log_level();
+
+// Sets the level of the calling thread until it is destroyed. Threads started by a run take the level of the thread that started them.
+class LogLevelScope {
+public:
+    explicit LogLevelScope(LogLevel level);
+    ~LogLevelScope();
+
+    LogLevelScope(const LogLevelScope&) = delete;
+    LogLevelScope& operator=(const LogLevelScope&) = delete;
+
+private:
+    std::optional<LogLevel> previous;
+};
+
+// Sends the log lines to `handler` instead of stdout, from the sink thread. An empty handler restores stdout.
+void set_log_handler(LogHandler handler);
+
+// Queues a formatted line for the sink thread.
+void write_log(MessageType type, std::string line);
+
+// Blocks until everything logged so far has been written.
+void flush_log();
+
+// Replaces the status line at the bottom of the terminal. An empty line removes it.
+void set_status(std::string line);
+
+template <LogLevel level>
+bool is_log_enabled() {
+    if constexpr (static_cast<int>(level) < DISCORD_RM_MIN_LOG_LEVEL) return false;
+    else if constexpr (level == LogLevel::INFO) return true;
+    else return static_cast<int>(level) >= static_cast<int>(log_level());
+}
+
+template <LogLevel level, typename... Args>
+void log_at(const MessageType type, fmt::format_string<Args...> format, Args&&... args) {
+    if constexpr (static_cast<int>(level) >= DISCORD_RM_MIN_LOG_LEVEL) {
+        if (is_log_enabled<level>()) write_log(type, fmt::format(format, std::forward<Args>(args)...));
+    }
+}
+
+template <typename... Args>
+void debug(fmt::format_string<Args...> format, Args&&... args) {
+    log_at<LogLevel::DEBUG>(OK, format, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+void verbose(fmt::format_string<Args...> format, Args&&... args) {
+    log_at<LogLevel::VERBOSE>(OK, format, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+void verbose(const MessageType type, fmt::format_string<Args...> format, Args&&... args) {
+    log_at<LogLevel::VERBOSE>(type, format, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+void info(fmt::format_string<Args...> format, Args&&... args) {
+    log_at<LogLevel::INFO>(OK, format, std::forward<Args>(args)...);
+}
+
+template <typename... Args>
+void info(const MessageType type, fmt::format_string<Args...> format, Args&&... args) {
+    log_at<LogLevel::INFO>(type, format, std::forward<Args>(args)...);
+}
@@ -0,0 +1,75 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+#ifdef _WIN32
+#include <fstream>
+#include <iterator>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file. Mapped where the platform allows it, read into memory otherwise.
+class MappedFile {
+public:
+    explicit MappedFile(const std::filesystem::path& path) {
+#ifdef _WIN32
+        std::ifstream in(path, std::ios::binary);
+        if (!in) throw std::runtime_error("Failed to open `" + path.string() + "`.");
+        contents.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+#else
+        const int fd = open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Failed to open `" + path.string() + "`.");
+
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            size = static_cast<size_t>(st.st_size);
+            data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+
+        if (data == MAP_FAILED) throw std::runtime_error("Failed to map `" + path.string() + "`.");
+        if (data) madvise(data, size, MADV_SEQUENTIAL); // Read once, front to back
+#endif
+    }
+
+    ~MappedFile() {
+#ifndef _WIN32
+        if (data && data != MAP_FAILED) munmap(data, size);
+#endif
+    }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    std::string_view view() const {
+#ifdef _WIN32
+        return contents;
+#else
+        return data ? std::string_view(static_cast<const char*>(data), size) : std::string_view();
+#endif
+    }
+
+private:
+#ifdef _WIN32
+    std::string contents;
+#else
+    void* data = nullptr;
+    size_t size = 0;
+#endif
+};
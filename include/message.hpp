@@ -0,0 +1,44 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <include/filter.hpp>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+
+/*
+ * A search result, reduced to the fields needed by the filters and the deletion.
+ * IDs are kept as 64-bit snowflakes; the content is only kept when it will be displayed or archived,
+ * and the JSON of the whole result only when it is archived.
+ */
+struct Message {
+    uint64_t id = 0;
+    uint64_t channel_id = 0;
+    FeatureSet features = 0; // See `Feature`, covers every attachment and embed
+    uint8_t type = 0;
+    uint8_t attempts = 0; // Failed delete attempts, see `RetryPolicy`
+    std::string content;
+    std::string raw;       // The search result, until it is handed to the archive
+    uint64_t archived = 0; // Sequence number in the archive, see `ArchiveWriter::wait`
+};
+
+struct SearchPage {
+    unsigned int total_results = 0;
+    std::vector<Message> messages;
+};
+
+/*
+ * Decodes a search response without building a JSON document.
+ * Only the fields of `Message` are read, everything else is skipped by the tokenizer.
+ * Results without an ID (not user messages) are left out. Throws on malformed JSON.
+ * With `keep_raw`, the JSON of every result is cut out of the body as it is parsed (`Message::raw`).
+ */
+void parse_search_page(std::string_view body, SearchPage& page, bool keep_content, bool keep_raw = false);
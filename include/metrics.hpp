@@ -0,0 +1,149 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct Response;
+
+enum class Endpoint { SEARCH, DELETE, BULK_DELETE };
+constexpr size_t ENDPOINT_COUNT = 3;
+
+// Why the run was waiting instead of sending a request.
+enum class WaitCause {
+    BUCKET,      // The route's bucket was empty (`X-RateLimit-Remaining`, 429)
+    GLOBAL,      // A global 429
+    FIXED_DELAY, // `--delay`
+    INDEX,       // The search index was not ready yet (202)
+    BACKOFF      // The route failed and is paused, see `RetryPolicy`
+};
+constexpr size_t WAIT_CAUSE_COUNT = 5;
+
+// Request latencies in fixed buckets, as Prometheus histograms expect them.
+class LatencyHistogram {
+public:
+    static constexpr std::array<uint32_t, 11> BOUNDS_MS = {5, 10, 25, 50, 100, 250, 500, 1000, 2500, 5000, 10000};
+
+    void observe(std::chrono::microseconds latency);
+    void reset();
+
+    // Requests in bucket `i`, the last one is above every bound.
+    uint64_t bucket(const size_t i) const { return buckets[i].load(std::memory_order_relaxed); }
+    uint64_t count() const;
+    std::chrono::microseconds sum() const { return std::chrono::microseconds(sum_us.load(std::memory_order_relaxed)); }
+
+private:
+    std::array<std::atomic<uint64_t>, BOUNDS_MS.size() + 1> buckets{};
+    std::atomic<int64_t> sum_us = 0;
+};
+
+// Message counts of a run so far, as the progress line shows them.
+struct RunCounts {
+    uint64_t expected = 0; // Search results reported by the first page of every searched range
+    uint64_t found = 0;    // Results handed to the discovery stages so far
+    uint64_t queued = 0;   // Passed the filters and queued for deletion
+    uint64_t deleted = 0;
+    uint64_t failed = 0;
+    uint64_t planned = 0;  // Written to the plan of a dry run
+    uint64_t skipped = 0;  // Excluded by the filters
+    uint64_t stale = 0;
+    std::chrono::nanoseconds blocked{}; // The delete stage had messages, but no bucket had room
+    std::chrono::nanoseconds elapsed{};
+};
+
+/*
+ * Counters of a run: requests per endpoint and HTTP status, latencies, bytes, waits by cause and deleted messages.
+ * Every update is a few relaxed atomic increments, so they can be recorded from any thread on every request.
+ * Reports are built from a snapshot of the counters and may be slightly behind the requests in flight.
+ */
+class Metrics {
+public:
+    static constexpr long MAX_STATUS = 600; // Transport errors are recorded as status 0
+
+    // Clears the counters and restarts the run clock.
+    void reset();
+
+    void request(Endpoint endpoint, const Response& response);
+    void waited(WaitCause cause, std::chrono::nanoseconds duration);
+    void deleted(uint64_t count = 1) { deleted_count.fetch_add(count, std::memory_order_relaxed); }
+    void failed(uint64_t count = 1) { failed_count.fetch_add(count, std::memory_order_relaxed); }
+    void stale(uint64_t count = 1) { stale_count.fetch_add(count, std::memory_order_relaxed); } // Search results already deleted
+    void expected(uint64_t count) { expected_count.fetch_add(count, std::memory_order_relaxed); }
+    void found(uint64_t count = 1) { found_count.fetch_add(count, std::memory_order_relaxed); }
+    void queued() { queued_count.fetch_add(1, std::memory_order_relaxed); }
+    void skipped() { skipped_count.fetch_add(1, std::memory_order_relaxed); }
+    void planned() { planned_count.fetch_add(1, std::memory_order_relaxed); }
+    void blocked(std::chrono::nanoseconds duration) { blocked_ns.fetch_add(duration.count(), std::memory_order_relaxed); }
+
+    RunCounts counts() const;
+
+    // Totals of the run, see `RunStats`. Unlike the counters of a shared `RateLimiter`, they leave out other runs.
+    uint64_t requests() const;
+    uint64_t rate_limited() const; // Answered with 429
+    uint64_t index_waits() const;  // Answered with 202, the search index was not ready
+    std::chrono::nanoseconds waited() const;
+
+    std::string to_json() const;
+    std::string to_prometheus() const; // Text exposition format, e.g. for the node exporter's textfile collector
+
+    // Writes `<prefix>.json` and `<prefix>.prom`. Each file is replaced at once, so readers never see half a report.
+    void write(const std::string& prefix) const;
+
+private:
+    struct EndpointMetrics {
+        std::array<std::atomic<uint64_t>, MAX_STATUS> status{};
+        std::atomic<uint64_t> bytes = 0;
+        LatencyHistogram latency;
+    };
+
+    std::chrono::duration<double> elapsed() const;
+
+    std::array<EndpointMetrics, ENDPOINT_COUNT> endpoints;
+    std::array<std::atomic<int64_t>, WAIT_CAUSE_COUNT> waited_ns{};
+    std::atomic<uint64_t> deleted_count = 0;
+    std::atomic<uint64_t> failed_count = 0;
+    std::atomic<uint64_t> stale_count = 0;
+    std::atomic<uint64_t> expected_count = 0;
+    std::atomic<uint64_t> found_count = 0;
+    std::atomic<uint64_t> queued_count = 0;
+    std::atomic<uint64_t> skipped_count = 0;
+    std::atomic<uint64_t> planned_count = 0;
+    std::atomic<int64_t> blocked_ns = 0;
+    std::atomic<std::chrono::steady_clock::rep> started = std::chrono::steady_clock::now().time_since_epoch().count();
+};
+
+// Async-signal-safe. Asks every running `MetricsReporter` to write a report now.
+void request_metrics_report();
+
+// Writes the report of `metrics` whenever one is requested, and a last one when destroyed.
+class MetricsReporter {
+public:
+    MetricsReporter(const Metrics& metrics, std::string prefix);
+    ~MetricsReporter();
+
+    MetricsReporter(const MetricsReporter&) = delete;
+    MetricsReporter& operator=(const MetricsReporter&) = delete;
+
+private:
+    const Metrics& metrics;
+    std::string prefix;
+    uint64_t reported = 0; // Requests seen so far, see `request_metrics_report`
+    std::mutex mutex;
+    std::condition_variable stopped;
+    bool is_stopping = false;
+    std::thread thread;
+};
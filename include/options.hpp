@@ -0,0 +1,23 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <include/job.hpp>
+#include <include/filter.hpp>
+
+/*
+ * The command line options of `config.hpp`, turned into library settings.
+ * Part of the command line (and the benchmarks), not of libdiscordrm.
+ */
+
+// Builds the rule mask from the `NO_*` options.
+FeatureSet compile_filter();
+
+// The job given by the command line options. IDs missing there are taken from the plan of `--execute-plan`.
+JobConfig job_from_options();
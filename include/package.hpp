@@ -0,0 +1,31 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <include/message.hpp>
+#include <include/job.hpp>
+#include <functional>
+#include <string>
+
+/*
+ * Reader for the `messages` folder of a Discord data package (Settings > Data & Privacy > Request Data):
+ *
+ *   messages/index.json                     { "<channel id>": "<channel name>", ... }
+ *   messages/c<channel id>/channel.json     { "id": ..., "guild": { "id": ... } }
+ *   messages/c<channel id>/messages.json    [ { "ID": ..., "Contents": ..., "Attachments": ... }, ... ]
+ *   messages/c<channel id>/messages.csv     ID,Timestamp,Contents,Attachments (older packages)
+ *
+ * The package only holds the messages of its owner. Channels are chosen by the guild and channel of the job,
+ * messages by its date range and mentions, like the search would. Features are derived from the
+ * attachment URLs and links in the content; pinned messages cannot be told apart.
+ *
+ * Files are memory-mapped and parsed in place, one channel at a time, so memory does not grow with the package.
+ * `on_message` is called for every message in scope; returning false stops the import.
+ */
+void read_data_package(const std::string& root, const JobConfig& job, bool keep_content, const std::function<bool(Message&)>& on_message);
@@ -0,0 +1,69 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <include/message.hpp>
+#include <include/filter.hpp>
+#include <include/job.hpp>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+
+/*
+ * Deletion plan, written by `--plan` and run by `--execute-plan`, one record per line:
+ *
+ *   H <guild id> <channel id> <sender id>       run header, as in the journal
+ *   M <channel id> <message id> <features>       a message to delete, features in hex (see `Feature`)
+ *
+ * Lines starting with '#' are comments. The summary (counts per channel and per feature,
+ * estimated requests and runtime) is appended as comments once the search is done.
+ */
+class PlanWriter {
+public:
+    // `delay` is the run's delay between requests, for the runtime estimate.
+    PlanWriter(const std::string& path, const JobConfig& job, std::chrono::milliseconds delay);
+    ~PlanWriter();
+
+    PlanWriter(const PlanWriter&) = delete;
+    PlanWriter& operator=(const PlanWriter&) = delete;
+
+    void add(const Message& message);
+
+    // Writes the summary to the plan and returns it.
+    std::string finish();
+
+private:
+    struct ChannelCount {
+        uint64_t messages = 0;
+        uint64_t bulk = 0; // Young enough for bulk delete at planning time
+    };
+
+    void write_pending();
+
+    std::ofstream file;
+    std::string pending;
+    std::map<uint64_t, ChannelCount> channels;
+    std::array<uint64_t, 16> features{}; // Messages per feature bit
+    uint64_t plain = 0;                  // Messages without any feature
+    uint64_t total = 0;
+    uint64_t oldest_bulk_ms;
+    std::chrono::milliseconds delay;
+    bool is_bulk; // Bulk delete is used in the planned channels
+};
+
+// Fills the IDs of the job that are not given on the command line from the plan header. Its settings are not taken,
+// the filters of the execution apply.
+void apply_plan_header(const std::string& path, JobConfig& job);
+
+// Calls `on_message` for every message of the plan, returning false stops reading.
+void read_plan(const std::string& path, const std::function<bool(Message&)>& on_message);
@@ -0,0 +1,71 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <include/metrics.hpp>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Whether stdout is a terminal, and can show a status line.
+bool is_terminal_output();
+
+// Progress of the running deletion, see `ProgressReporter`.
+struct Progress {
+    RunCounts counts;
+    double current = 0; // Messages deleted or planned per second, over the last `RATE_WINDOW`
+    double average = 0; // The same, as a moving average over the run
+    double blocked = 0; // Share of the last `RATE_WINDOW` the delete stage was held up by rate limits, from 0 to 1
+};
+
+/*
+ * Reports the progress of the running deletion from its own thread at a fixed rate, and never per message:
+ * the counts of the run, the deletion rate of the last seconds and of the run (a moving average),
+ * and the share of time the delete stage was held up by rate limits.
+ * Everything is read from the metrics of the run, so the stages pay nothing for it but a few relaxed counters.
+ *
+ * The CLI shows it as a status line below the log on a terminal, and logs a summary line otherwise.
+ */
+class ProgressReporter {
+public:
+    static constexpr auto RATE_WINDOW = std::chrono::seconds(5);     // Of the current rate
+    static constexpr auto AVERAGE_WINDOW = std::chrono::seconds(60); // Time constant of the moving average
+
+    ProgressReporter(const Metrics& metrics, std::chrono::milliseconds interval, std::function<void(const Progress&)> on_progress);
+    ~ProgressReporter();
+
+    ProgressReporter(const ProgressReporter&) = delete;
+    ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+private:
+    struct Sample {
+        std::chrono::nanoseconds at{}; // Since the start of the run
+        uint64_t done = 0;             // Deleted or planned
+        std::chrono::nanoseconds blocked{};
+    };
+
+    void update();
+
+    const Metrics& metrics;
+    std::function<void(const Progress&)> on_progress;
+    std::deque<Sample> samples; // Of the last `RATE_WINDOW`, and one before it
+    double average = 0;         // Messages per second
+    std::mutex mutex;
+    std::condition_variable stopped;
+    bool is_stopping = false;
+    std::thread thread;
+};
+
+// The progress line: messages deleted, skipped and left, the rates, and the time left at the average rate.
+std::string format_progress(const Progress& progress);
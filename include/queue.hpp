@@ -0,0 +1,79 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <utility>
+
+/*
+ * Bounded multi-producer/multi-consumer queue.
+ * `push` blocks while the queue is full (backpressure), `pop` blocks while it is empty.
+ */
+template <typename T>
+class BoundedQueue {
+public:
+    explicit BoundedQueue(const size_t capacity) : capacity(capacity) {}
+
+    // Returns false if the queue was closed.
+    bool push(T item) {
+        std::unique_lock lock(mutex);
+        not_full.wait(lock, [&] { return closed || items.size() < capacity; });
+        if (closed) return false;
+
+        items.push_back(std::move(item));
+        not_empty.notify_one();
+        return true;
+    }
+
+    // Returns false once the queue is closed and empty.
+    bool pop(T& item) {
+        std::unique_lock lock(mutex);
+        not_empty.wait(lock, [&] { return closed || !items.empty(); });
+        if (items.empty()) return false;
+
+        item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    // Returns false if the queue is empty right now.
+    bool try_pop(T& item) {
+        std::scoped_lock lock(mutex);
+        if (items.empty()) return false;
+
+        item = std::move(items.front());
+        items.pop_front();
+        not_full.notify_one();
+        return true;
+    }
+
+    // Returns true once the queue is closed and empty, so nothing will ever be popped again.
+    bool is_drained() {
+        std::scoped_lock lock(mutex);
+        return closed && items.empty();
+    }
+
+    void close() {
+        std::scoped_lock lock(mutex);
+        closed = true;
+        not_full.notify_all();
+        not_empty.notify_all();
+    }
+
+private:
+    std::mutex mutex;
+    std::condition_variable not_full, not_empty;
+    std::deque<T> items;
+    size_t capacity;
+    bool closed = false;
+};
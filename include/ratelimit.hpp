@@ -0,0 +1,82 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <include/client.hpp>
+#include <include/metrics.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+/*
+ * Rate limit scheduler driven by the response headers.
+ *
+ * Routes are named "<name>:<major parameter>", e.g. "delete:<channel id>".
+ * Discord maps every route to a bucket (`X-RateLimit-Bucket`), and the bucket state
+ * (`X-RateLimit-Remaining`, `X-RateLimit-Reset-After`) is shared by all routes with the same major parameter.
+ * `acquire` waits only as long as the bucket, the global limit or the optional fixed delay requires.
+ */
+class RateLimiter {
+public:
+    using clock = std::chrono::steady_clock;
+
+    explicit RateLimiter(std::chrono::milliseconds min_delay = std::chrono::milliseconds(0));
+
+    /*
+     * Blocks until a request on the route may be sent. The waits are recorded in `metrics`, of the run that sends the request.
+     * Returns false without reserving anything once `stop` is set, e.g. when the run is cancelled.
+     */
+    bool acquire(const std::string& route, Metrics& metrics, const std::atomic<bool>& stop);
+
+    // Reserves a request on the route if one may be sent right now, without waiting.
+    bool try_acquire(const std::string& route);
+
+    // Earliest time `acquire` would return for the route, without reserving anything. `cause` tells what it waits for.
+    clock::time_point ready_at(const std::string& route, WaitCause* cause = nullptr);
+
+    // Reads the rate limit state from a response. Every reserved request must be answered here, even if it failed.
+    // Returns true if the request was rate limited and must be retried.
+    bool update(const std::string& route, const Response& response);
+
+    // Holds back requests on the route until `until`, e.g. after a server error.
+    void pause(const std::string& route, clock::time_point until);
+
+    uint64_t requests() const { return request_count; }
+    uint64_t rate_limited() const { return rate_limited_count; } // 429
+    uint64_t index_waits() const { return index_wait_count; }     // 202, the search index was not ready
+    std::chrono::nanoseconds waited() const { return std::chrono::nanoseconds(waited_ns); } // Total time spent in `acquire`
+
+private:
+    struct Bucket {
+        int limit = 1;
+        int remaining = 1;  // Left in the window, minus the requests in flight
+        int in_flight = 0;  // Sent, but not answered yet
+        bool is_indexing = false; // Empty because the search index is not ready (202), not because of the limit
+        clock::time_point reset_at{};
+    };
+
+    Bucket& bucket_of(const std::string& route);
+    clock::time_point available_at(const std::string& route, clock::time_point now, WaitCause& cause);
+    void reserve(const std::string& route, clock::time_point now);
+
+    std::mutex mutex;
+    std::unordered_map<std::string, std::string> route_buckets; // Route -> bucket key
+    std::unordered_map<std::string, Bucket> buckets;
+    std::unordered_map<std::string, clock::time_point> last_requests; // Route -> time of the last request
+    std::unordered_map<std::string, clock::time_point> paused_until;  // Route -> end of its pause
+    clock::time_point global_reset_at{};
+    std::chrono::milliseconds min_delay;
+    std::atomic<uint64_t> request_count = 0;
+    std::atomic<uint64_t> rate_limited_count = 0;
+    std::atomic<uint64_t> index_wait_count = 0;
+    std::atomic<int64_t> waited_ns = 0;
+};
@@ -8,4 +8,118 @@
 
 #pragma once
 
-void discord_rm();
+#include <include/job.hpp>
+#include <include/progress.hpp>
+#include <include/ratelimit.hpp>
+#include <include/metrics.hpp>
+#include <include/client.hpp>
+#include <include/logger.hpp>
+#include <include/config.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Outcome of one job.
+struct JobStats {
+    uint64_t deleted = 0;
+    uint64_t failed = 0;
+    uint64_t planned = 0;     // Written to the plan by `--plan`
+    std::string plan_summary; // Of the plan, see `PlanWriter::finish`
+    std::string error;        // Why the job stopped early, empty if it ran to the end
+};
+
+// Outcome of a run. The counts are of this run only, even with a shared limiter.
+struct RunStats {
+    std::vector<JobStats> jobs; // In the order the jobs were given
+    uint64_t requests = 0;
+    uint64_t rate_limited = 0; // Answered with 429
+    uint64_t index_waits = 0;  // Answered with 202, the search index was not ready
+    uint64_t retries = 0; // Sent again after a network or server error
+    std::chrono::nanoseconds rate_limit_wait{};
+    bool interrupted = false; // Stopped by `Remover::cancel`, can be continued with `--resume`
+};
+
+// Something that happened to a message or job, see `RemoverConfig::on_event`.
+struct RemoverEvent {
+    enum class Type { DELETED, FAILED, JOB_FINISHED };
+
+    Type type;
+    size_t job = 0;          // Position in `RemoverConfig::jobs`
+    uint64_t message_id = 0; // Not set for `JOB_FINISHED`
+    uint64_t channel_id = 0;
+    std::string error;       // Why the message or job failed
+};
+
+/*
+ * Settings of a run, shared by all of its jobs. The CLI fills them from its options,
+ * a program that embeds the library fills them itself; nothing here is read from the option globals of `config.hpp`.
+ */
+struct RemoverConfig {
+    std::vector<JobConfig> jobs;
+    std::string token;
+    std::string api_url = DISCORD_API_URL_BASE_DEFAULT;
+    std::chrono::milliseconds delay{DELAY_IN_MS_DEFAULT}; // Between two requests of a route, on top of the rate limits
+
+    // Rate limit state and connections, shared with other runs of the same account, at the same time or one after another.
+    // A run of its own if empty.
+    std::shared_ptr<RateLimiter> limiter;
+    std::shared_ptr<ConnectionPool> connections;
+
+    LogLevel log_level = LogLevel::INFO; // Of the threads of the run, see `LogLevelScope`
+
+    bool display = false;            // Log the content of every message before it is deleted
+    unsigned int display_length = 100;
+    std::string metrics_path;        // `--metrics`
+    std::string archive_path;        // `--archive`
+    std::string record_path;         // `--record`
+    std::string replay_path;         // `--replay`
+    bool replay_fast = false;
+
+    // Called from a thread of its own every `progress_interval`, and never for a single message.
+    std::function<void(const Progress&)> on_progress;
+    std::chrono::milliseconds progress_interval = std::chrono::milliseconds(500);
+
+    // Called from the delete stage for every deleted or failed message, and once per job at the end of the run.
+    // It holds up the deletions while it runs, so it should return quickly.
+    std::function<void(const RemoverEvent&)> on_event;
+};
+
+/*
+ * Runs the jobs side by side until each of them is done or has failed. A failing job does not stop the others.
+ * All jobs share one connection pool and one rate limiter, and their deletions are interleaved,
+ * so every job moves forward whenever one of its buckets has room.
+ *
+ * Nothing is printed or asked: the outcome is returned, and the log goes through `logger.hpp`.
+ * Every remover has its own metrics, cassette and log level, so a process can run several at once,
+ * e.g. one per account of a service; removers of the same account should share `limiter` and `connections`.
+ */
+class Remover {
+public:
+    explicit Remover(RemoverConfig config) : config(std::move(config)) {}
+
+    Remover(const Remover&) = delete;
+    Remover& operator=(const Remover&) = delete;
+
+    // Blocks until the run is over. Throws only if the run cannot start; the errors of jobs are in their stats.
+    RunStats run();
+
+    // Thread-safe and async-signal-safe. Lets the requests in flight finish, then `run` flushes the journals and returns.
+    // A cancelled remover stays cancelled, a later `run` returns at once.
+    void cancel() { cancelled = true; }
+
+    const RemoverConfig& settings() const { return config; }
+
+    // Counters of the current or last run. Thread-safe, read while `run` is going they are slightly behind.
+    const Metrics& metrics() const { return run_metrics; }
+
+private:
+    RemoverConfig config;
+    std::atomic<bool> cancelled = false;
+    Metrics run_metrics;
+};
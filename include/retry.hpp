@@ -0,0 +1,88 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <include/client.hpp>
+#include <include/ratelimit.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+// What went wrong with a request, as far as retrying it is concerned.
+enum class Failure {
+    NONE,         // Answered with 2xx
+    RATE_LIMITED, // 429, or the search index is not ready yet (202). Waited out by `RateLimiter`
+    NETWORK,      // Transient transport error: timeout, refused or reset connection, DNS failure
+    SERVER,       // 5xx
+    DISCORD,      // 4xx with a Discord error code, see `discord_error_code`
+    PERMANENT,    // Any other 4xx or transport error, sending it again gives the same answer
+    CANCELLED     // Aborted because the run is cancelled, see `Client`
+};
+
+// `is_rate_limited` is what `RateLimiter::update` returned for the response.
+Failure classify(const Response& response, bool is_rate_limited);
+
+// The `code` of a Discord error body, e.g. 50083 for an archived thread. 0 if the body has none.
+int discord_error_code(const Response& response);
+
+// What went wrong, for messages: the curl error or the HTTP status.
+std::string failure_reason(const Response& response);
+
+/*
+ * Retry policy for transient failures (`Failure::NETWORK` and `Failure::SERVER`).
+ *
+ * A request is sent at most `MAX_ATTEMPTS` times. After each transient failure its route is paused
+ * with decorrelated jitter: the next pause is drawn between `BASE_DELAY` and three times the last one,
+ * capped at `MAX_DELAY`, so clients that failed together do not retry together.
+ * A route that fails `BREAKER_FAILURES` times in a row has its circuit opened: nothing is sent on it
+ * for `BREAKER_PAUSE`, then a single request probes it again. Any other answer closes the circuit.
+ *
+ * Pauses are set on the `RateLimiter`, so the waits and the delete scheduling honour them like any other limit.
+ * Thread-safe, shared by every stage of the run.
+ */
+class RetryPolicy {
+public:
+    using clock = RateLimiter::clock;
+
+    static constexpr uint8_t MAX_ATTEMPTS = 5;
+    static constexpr uint8_t MAX_RATE_LIMITED = 50; // Rate limited answers to one request, waited out apart from `MAX_ATTEMPTS`
+    static constexpr uint32_t BREAKER_FAILURES = 8;
+    static constexpr auto BASE_DELAY = std::chrono::milliseconds(100);
+    static constexpr auto MAX_DELAY = std::chrono::seconds(15);
+    static constexpr auto BREAKER_PAUSE = std::chrono::seconds(30);
+
+    explicit RetryPolicy(RateLimiter& limiter);
+
+    static bool is_transient(const Failure failure) { return failure == Failure::NETWORK || failure == Failure::SERVER; }
+
+    /*
+     * Records the outcome of a request on the route. A transient failure pauses the route;
+     * `attempts` counts the failed attempts of the request and is increased.
+     * Returns true if the request is to be sent again.
+     */
+    bool should_retry(const std::string& route, Failure failure, uint8_t& attempts);
+
+    uint64_t retries() const { return retry_count; } // Requests sent again after a transient failure
+
+private:
+    struct Route {
+        uint32_t failures = 0;       // In a row
+        clock::duration last_delay{}; // Of the last pause, the next one is drawn from it
+    };
+
+    RateLimiter& limiter;
+    std::mutex mutex;
+    std::unordered_map<std::string, Route> routes;
+    std::mt19937_64 random{std::random_device{}()};
+    std::atomic<uint64_t> retry_count = 0;
+};
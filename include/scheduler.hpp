@@ -0,0 +1,91 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <include/message.hpp>
+#include <include/ratelimit.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Delete endpoints of one channel.
+struct Channel {
+    enum class Bulk { UNKNOWN, ALLOWED, DENIED }; // Known after the first bulk delete in the channel
+
+    uint64_t id = 0;
+    std::string messages;     // Channel messages URL, the message ID is appended
+    std::string bulk_delete;  // Bulk delete URL
+    std::string delete_route; // Rate limit routes, see `RateLimiter`
+    std::string bulk_route;
+    Bulk bulk = Bulk::UNKNOWN;
+};
+
+/*
+ * Per-channel work queues of the delete stage.
+ *
+ * Every channel has its own delete bucket, so `try_pop` takes messages from any channel whose bucket
+ * has room. A throttled channel does not hold up the others, and channels that are ready
+ * at the same time take turns.
+ *
+ * With `bulk`, messages that the bulk delete endpoint accepts (younger than 14 days, not system messages)
+ * are taken in batches of up to `BULK_DELETE_LIMIT`, unless the channel is known to deny it. They are kept
+ * apart from the others as they are queued, so where they are in the channel's queue does not matter:
+ * time shards are searched side by side, and the results of a channel are not in any order.
+ */
+class ChannelScheduler {
+public:
+    static constexpr size_t BULK_DELETE_LIMIT = 100;
+
+    // Unix time in milliseconds before which messages are too old for bulk delete.
+    static uint64_t bulk_cutoff_ms();
+    static bool is_bulk_deletable(const Message& message, uint64_t cutoff_ms);
+
+    // `channels_url` is the channels endpoint, e.g. "https://discord.com/api/v10/channels/".
+    ChannelScheduler(std::string channels_url, const bool bulk) : channels_url(std::move(channels_url)), bulk(bulk) {}
+
+    void push(Message message);
+
+    /*
+     * Removes the next messages to delete, all from the same channel whose bucket has room right now,
+     * reserves the request with the limiter and returns the channel. Returns nullptr if no channel is ready.
+     * The batch has a single message unless it can be bulk deleted.
+     */
+    Channel* try_pop(RateLimiter& limiter, std::vector<Message>& batch);
+
+    // Puts a batch back at the front of its channel, e.g. after a 429. With `singly`, the messages are not bulk deleted again.
+    void retry(const Channel& channel, std::vector<Message>& batch, bool singly);
+
+    // Earliest time a queued channel can send its next request, and what that channel waits for.
+    RateLimiter::clock::time_point ready_at(RateLimiter& limiter, WaitCause* cause = nullptr) const;
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+private:
+    struct Queue {
+        Channel channel;
+        std::deque<Message> singles;  // Refused by bulk delete, taken first
+        std::deque<Message> recent;   // Bulk deletable when queued
+        std::deque<Message> messages; // Deleted one by one
+    };
+
+    bool is_bulk_batch(const Queue& queue, uint64_t cutoff_ms) const;
+    const std::string& next_route(const Queue& queue, uint64_t cutoff_ms) const;
+
+    std::string channels_url;
+    bool bulk;
+    std::deque<Queue> queues; // A deque, so channels handed out stay valid while new ones are added
+    std::unordered_map<uint64_t, size_t> index; // Channel ID -> position in `queues`
+    size_t turn = 0; // Where the search for a ready channel starts, for round robin
+    size_t count = 0;
+};
@@ -0,0 +1,63 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <include/helpers.hpp>
+#include <include/config.hpp>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+/*
+ * Time shards of one search, shared by its workers.
+ *
+ * A shard is a snowflake range that is walked on its own, newest page first. Bounds are exclusive,
+ * so shards never overlap and no message is found by two of them.
+ * Shards are split while they are searched: when a page reports more than `SPLIT_RESULTS` results left
+ * and a worker is idle, the older half of what the shard has left becomes a new shard for that worker.
+ * Deep histories are thus searched by every worker at once instead of one page after another.
+ */
+class ShardQueue {
+public:
+    static constexpr uint64_t SPLIT_RESULTS = PAGE_LIMIT * 4;
+    static constexpr uint64_t MIN_SPAN_MS = 60 * 60 * 1000; // Shards shorter than this are not split any further
+
+    explicit ShardQueue(const std::vector<SnowflakeRange>& shards) : pending(shards.begin(), shards.end()), initial(shards.size()) {}
+
+    /*
+     * Takes a shard to search. Waits while other workers may still split theirs, and returns false once all are searched.
+     * `is_initial` tells if it is one of the shards the queue was built with, and not split off another one.
+     */
+    bool take(SnowflakeRange& shard, bool& is_initial);
+
+    // Called with what is left of the worker's shard after a page. May hand its older half to an idle worker and narrow `rest`.
+    void split(SnowflakeRange& rest, uint64_t total_results);
+
+    // The shard taken last by the worker is searched.
+    void finish();
+
+    // Wakes every waiting worker; `take` returns false from now on.
+    void stop();
+    bool is_stopping();
+
+private:
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<SnowflakeRange> pending;
+    size_t initial = 0; // Initial shards not taken yet, they are at the front of `pending`
+    size_t active = 0;  // Shards being searched
+    size_t waiting = 0; // Workers waiting in `take`
+    bool is_stopped = false;
+};
+
+// The parts of `range` that are outside of all `searched` ranges, e.g. what is left to search when a run is resumed.
+std::vector<SnowflakeRange> subtract_ranges(const SnowflakeRange& range, std::vector<SnowflakeRange> searched);
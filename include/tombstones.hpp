@@ -0,0 +1,62 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#pragma once
+
+#include <include/idset.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+/*
+ * Messages of a run that need no request: deleted by this run or by the earlier runs of a resumed journal,
+ * or claimed by another job of the run.
+ *
+ * The search index lags behind deletions, so deleted messages keep showing up in results for a while,
+ * and jobs whose ranges overlap find the same messages. The first job to queue a message claims it;
+ * the others leave it out, so no request is spent on a message that is gone or being deleted elsewhere.
+ * Read by the discovery threads and written by the delete stage, hence the lock.
+ */
+class Tombstones {
+public:
+    explicit Tombstones(const size_t jobs) : claims(jobs) {}
+
+    // The message is deleted.
+    void bury(const uint64_t id) {
+        std::unique_lock lock(mutex);
+        deleted.insert(id);
+    }
+
+    // Deleted, or claimed by a job other than `job`.
+    bool is_taken(const uint64_t id, const size_t job) const {
+        std::shared_lock lock(mutex);
+        return is_taken_locked(id, job);
+    }
+
+    // Claims the message for `job`. Returns false if it is taken.
+    bool claim(const uint64_t id, const size_t job) {
+        std::unique_lock lock(mutex);
+        if (is_taken_locked(id, job)) return false;
+        claims[job].insert(id);
+        return true;
+    }
+
+private:
+    bool is_taken_locked(const uint64_t id, const size_t job) const {
+        if (deleted.contains(id)) return true;
+        for (size_t other = 0; other < claims.size(); ++other)
+            if (other != job && claims[other].contains(id)) return true;
+        return false;
+    }
+
+    mutable std::shared_mutex mutex;
+    IdSet deleted;
+    std::vector<IdSet> claims; // Per job
+};
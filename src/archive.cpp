@@ -0,0 +1,182 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/archive.hpp>
+#include <nlohmann/json.hpp>
+#include <zlib.h>
+#include <cstdint>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace {
+    constexpr int GZIP_WINDOW_BITS = 15 + 16; // The largest window, with a gzip header and trailer
+
+    std::string gzip(const std::string& data) {
+        z_stream stream{};
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, GZIP_WINDOW_BITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            throw std::runtime_error("Failed to start compressing the archive.");
+
+        std::string out(deflateBound(&stream, static_cast<uLong>(data.size())), '\0');
+        stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+        stream.avail_in = static_cast<uInt>(data.size());
+        stream.next_out = reinterpret_cast<Bytef*>(out.data());
+        stream.avail_out = static_cast<uInt>(out.size());
+
+        const int result = deflate(&stream, Z_FINISH); // The output is large enough for a single call
+        out.resize(stream.total_out);
+        deflateEnd(&stream);
+        if (result != Z_STREAM_END) throw std::runtime_error("Failed to compress the archive.");
+        return out;
+    }
+
+    // Decompresses the gzip member that starts at the current position of `in`.
+    std::string gunzip_member(std::ifstream& in) {
+        z_stream stream{};
+        if (inflateInit2(&stream, GZIP_WINDOW_BITS) != Z_OK) throw std::runtime_error("Failed to start reading the archive.");
+
+        std::string out;
+        char input[16 * 1024], output[64 * 1024];
+        int result = Z_OK;
+        while (result != Z_STREAM_END) {
+            if (stream.avail_in == 0) {
+                in.read(input, sizeof(input));
+                if (in.gcount() == 0) break; // Torn member
+                stream.next_in = reinterpret_cast<Bytef*>(input);
+                stream.avail_in = static_cast<uInt>(in.gcount());
+            }
+            stream.next_out = reinterpret_cast<Bytef*>(output);
+            stream.avail_out = sizeof(output);
+            result = inflate(&stream, Z_NO_FLUSH);
+            if (result != Z_OK && result != Z_STREAM_END) break;
+            out.append(output, sizeof(output) - stream.avail_out);
+        }
+        inflateEnd(&stream);
+        if (result != Z_STREAM_END) throw std::runtime_error("The archive is damaged.");
+        return out;
+    }
+}
+
+ArchiveWriter::ArchiveWriter(const std::string& path) {
+    file.open(path, std::ios::binary | std::ios::app);
+    index_file.open(path + ".idx", std::ios::app);
+    if (!file || !index_file) throw std::runtime_error("Failed to open archive `" + path + "`.");
+
+    offset = std::filesystem::file_size(path); // Appended members start after the existing ones
+    thread = std::thread([this] { run(); });
+}
+
+ArchiveWriter::~ArchiveWriter() {
+    {
+        std::scoped_lock lock(mutex);
+        is_stopping = true;
+    }
+    changed.notify_all();
+    thread.join();
+}
+
+uint64_t ArchiveWriter::add(const uint64_t id, std::string json) {
+    std::unique_lock lock(mutex);
+    changed.wait(lock, [this] { return pending_bytes < BUFFER_LIMIT || error; });
+    if (error) std::rethrow_exception(error);
+
+    pending_bytes += json.size();
+    pending.emplace_back(id, std::move(json));
+    changed.notify_all();
+    return ++added;
+}
+
+void ArchiveWriter::wait(const uint64_t sequence) {
+    std::unique_lock lock(mutex);
+    changed.wait(lock, [&] { return written >= sequence || error; });
+    if (written < sequence) std::rethrow_exception(error);
+}
+
+void ArchiveWriter::run() {
+    std::string records, index;
+    std::unique_lock lock(mutex);
+    while (true) {
+        changed.wait(lock, [this] { return is_stopping || !pending.empty(); });
+        if (pending.empty()) return;
+
+        // A member is closed once it is full or nothing else is waiting, so `wait` never waits for more records
+        records.clear();
+        index.clear();
+        uint64_t count = 0;
+        while (!pending.empty() && records.size() < MEMBER_SIZE) {
+            auto& [id, json] = pending.front();
+            index += std::to_string(id) + ' ' + std::to_string(offset) + '\n';
+            records += json;
+            records += '\n';
+            pending_bytes -= json.size();
+            pending.pop_front();
+            ++count;
+        }
+        changed.notify_all(); // Room in the buffer
+        lock.unlock();
+
+        try {
+            write_member(records, index);
+        } catch (...) {
+            lock.lock();
+            error = std::current_exception();
+            changed.notify_all();
+            return;
+        }
+
+        lock.lock();
+        written += count;
+        changed.notify_all();
+    }
+}
+
+void ArchiveWriter::write_member(const std::string& records, const std::string& index) {
+    const std::string member = gzip(records);
+    file.write(member.data(), static_cast<std::streamsize>(member.size()));
+    file.flush();
+    if (!file) throw std::runtime_error("Failed to write the archive.");
+    offset += member.size();
+
+    // After the member, so the index never points past the end of the archive
+    index_file << index;
+    index_file.flush();
+    if (!index_file) throw std::runtime_error("Failed to write the archive index.");
+}
+
+std::optional<std::string> find_archived(const std::string& path, const uint64_t id) {
+    std::ifstream index(path + ".idx");
+    if (!index) throw std::invalid_argument("Archive index `" + path + ".idx` does not exist.");
+
+    std::optional<uint64_t> member;
+    uint64_t record_id = 0, member_offset = 0;
+    while (index >> record_id >> member_offset)
+        if (record_id == id) member = member_offset;
+    if (!member) return std::nullopt;
+
+    std::ifstream in(path, std::ios::binary);
+    if (!in.seekg(static_cast<std::streamoff>(*member))) throw std::runtime_error("The archive is shorter than its index.");
+    const std::string records = gunzip_member(in);
+
+    const std::string id_text = std::to_string(id);
+    std::optional<std::string> found;
+    for (size_t start = 0, end; start < records.size(); start = end + 1) {
+        end = records.find('\n', start);
+        if (end == std::string::npos) end = records.size();
+        const std::string_view line(records.data() + start, end - start);
+
+        const auto record = nlohmann::json::parse(line, nullptr, false);
+        if (!record.is_discarded() && record.is_object() && record.value("id", "") == id_text) found = std::string(line);
+    }
+    return found;
+}
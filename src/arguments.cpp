@@ -10,6 +10,7 @@
 #include <include/config.hpp>
 #include <include/helpers.hpp>
 #include <stdexcept>
+#include <string>
 
 argparse::ArgumentParser& create_arguments() {
     using namespace argparse;
@@ -28,9 +29,12 @@ argparse::ArgumentParser& create_arguments() {
         .default_value(false)
         .implicit_value(true);
     program.add_argument("-dl", "--delay")
-        .help("Delay time in milliseconds")
+        .help("Minimum delay between requests in milliseconds")
         .scan<'u', unsigned int>()
         .default_value(DELAY_IN_MS_DEFAULT);
+    program.add_argument("-api", "--api-url")
+        .help("Discord API base URL (for testing against a local server)")
+        .default_value(std::string(DISCORD_API_URL_BASE_DEFAULT));
     program.add_argument("-i", "--interactive")
         .help("Interactive mode")
         .default_value(false)
@@ -47,7 +51,7 @@ argparse::ArgumentParser& create_arguments() {
         .help("Specify the guild ID (server ID)");
     program.add_argument("-c", "--channel-id")
         .default_value(std::string(""))
-        .help("Specify the channel ID");
+        .help("Specify the channel ID (leave out to clean the whole guild)");
     program.add_argument("-m", "--mentions")
         .help("Specify the mentioned user ID")
         .nargs(argparse::nargs_pattern::any)
@@ -69,6 +73,52 @@ argparse::ArgumentParser& create_arguments() {
     program.add_argument("-a", "--after-date")
         .help("Will only delete messages after this date (ISO 8601 e.g. 2015-01-01T00:00:00)")
         .default_value(std::string());
+    program.add_argument("-j", "--journal")
+        .help("Write a checkpoint journal to this file")
+        .default_value(std::string());
+    program.add_argument("-r", "--resume")
+        .help("Continue an interrupted run from its journal (requires `--journal`)")
+        .default_value(false)
+        .implicit_value(true);
+    program.add_argument("-imp", "--import")
+        .help("Take the messages from a Discord data package folder instead of searching")
+        .default_value(std::string());
+    program.add_argument("-pl", "--plan")
+        .help("Only search and filter, and write what would be deleted to this plan file")
+        .default_value(std::string());
+    program.add_argument("-ep", "--execute-plan")
+        .help("Delete the messages of a plan file without searching")
+        .default_value(std::string());
+    program.add_argument("-mt", "--metrics")
+        .help("Write a metrics report to <path>.json and <path>.prom on exit and on SIGUSR1")
+        .default_value(std::string());
+    program.add_argument("-ar", "--archive")
+        .help("Append every message to this gzip archive (JSON lines) before it is deleted")
+        .default_value(std::string());
+    program.add_argument("-af", "--archive-find")
+        .help("Print the archived message with this ID and exit (requires `--archive`)")
+        .default_value(std::string());
+    program.add_argument("-rec", "--record")
+        .help("Record every request and response of the run to this folder")
+        .default_value(std::string());
+    program.add_argument("-rpl", "--replay")
+        .help("Answer the requests from a `--record` folder instead of the network")
+        .default_value(std::string());
+    program.add_argument("-rpf", "--replay-fast")
+        .help("Replay without the recorded response times and rate limit waits (requires `--replay`)")
+        .default_value(false)
+        .implicit_value(true);
+    program.add_argument("-npg", "--no-progress")
+        .help("Do not show the progress line")
+        .default_value(false)
+        .implicit_value(true);
+    program.add_argument("-jb", "--jobs")
+        .help("Run the jobs of a JSON manifest side by side, the other options are their defaults")
+        .default_value(std::string());
+    program.add_argument("-bk", "--bulk")
+        .help("Bulk delete recent guild messages where the account has Manage Messages")
+        .default_value(false)
+        .implicit_value(true);
     program.add_argument("-nl", "--no-link")
         .help("Do not remove links")
         .default_value(false)
@@ -121,15 +171,53 @@ void process_arguments(ArgumentParser& program, int argc, char** argv) {
     const auto guild      = program.get<std::string>("--guild-id");
     const auto channel    = program.get<std::string>("--channel-id");
 
-    if (!is_interactive) {
+    const auto plan         = program.get<std::string>("--plan");
+    const auto execute_plan = program.get<std::string>("--execute-plan");
+    const auto jobs         = program.get<std::string>("--jobs");
+    const auto archive      = program.get<std::string>("--archive");
+    const auto archive_find = program.get<std::string>("--archive-find");
+
+    if (!archive_find.empty()) { // Only reads the archive, nothing else is needed
+        if (archive.empty()) throw std::invalid_argument("`--archive-find` requires `--archive`.");
+        if (archive_find.find_first_not_of("0123456789") != std::string::npos)
+            throw std::invalid_argument("`--archive-find` takes a message ID.");
+        ARCHIVE_PATH = archive;
+        ARCHIVE_FIND = archive_find;
+        return;
+    }
+
+    if (!jobs.empty()) {
+        if (is_interactive) throw std::invalid_argument("`--jobs` and `--interactive` cannot be used together.");
+        for (const char* option : {"--journal", "--import", "--plan", "--execute-plan"})
+            if (!program.get<std::string>(option).empty())
+                throw std::invalid_argument(std::string("`") + option + "` is set per job in the `--jobs` manifest.");
+        if (program.get<bool>("--resume")) throw std::invalid_argument("`--resume` is set per job in the `--jobs` manifest.");
+    }
+
+    if (!is_interactive && execute_plan.empty() && jobs.empty()) { // A plan or the manifest carries its own IDs
         if (sender.empty())
             throw std::invalid_argument("`--sender-id` is required unless `--interactive` is set.");
         if (guild.empty())
             throw std::invalid_argument("`--guild-id` is required unless `--interactive` is set.");
-        if (channel.empty())
-            throw std::invalid_argument("`--channel-id` is required unless `--interactive` is set.");
+        if (channel.empty() && is_dm_guild(guild))
+            throw std::invalid_argument("`--channel-id` is required for DMs unless `--interactive` is set.");
     }
 
+    if (program.get<bool>("--resume") && program.get<std::string>("--journal").empty())
+        throw std::invalid_argument("`--resume` requires `--journal`.");
+    if (!plan.empty() && !execute_plan.empty())
+        throw std::invalid_argument("`--plan` and `--execute-plan` cannot be used together.");
+    if (!plan.empty() && !program.get<std::string>("--journal").empty())
+        throw std::invalid_argument("`--plan` deletes nothing, so it has no journal.");
+    if (!execute_plan.empty() && !program.get<std::string>("--import").empty())
+        throw std::invalid_argument("`--execute-plan` and `--import` cannot be used together.");
+    if (!program.get<std::string>("--record").empty() && !program.get<std::string>("--replay").empty())
+        throw std::invalid_argument("`--record` and `--replay` cannot be used together.");
+    if (program.get<bool>("--replay-fast") && program.get<std::string>("--replay").empty())
+        throw std::invalid_argument("`--replay-fast` requires `--replay`.");
+    if (!execute_plan.empty() && !archive.empty())
+        throw std::invalid_argument("A plan only has message IDs, so `--execute-plan` cannot be used with `--archive`.");
+
     auto before_date         = program.get<std::string>("--before-date");
     auto during_date          = program.get<std::string>("--during-date");
     auto after_date          = program.get<std::string>("--after-date");
@@ -139,6 +227,7 @@ void process_arguments(ArgumentParser& program, int argc, char** argv) {
     GUILD_ID            = guild;
     CHANNEL_ID          = channel;
     DELAY_IN_MS         = program.get<unsigned int>("--delay");
+    DISCORD_API_URL_BASE = program.get<std::string>("--api-url");
     IS_VERBOSE          = program.get<bool>("--verbose");
     IS_DEBUG            = program.get<bool>("--debug");
     IS_NOCONFIRM        = program.get<bool>("--no-confirm");
@@ -146,6 +235,19 @@ void process_arguments(ArgumentParser& program, int argc, char** argv) {
     MENTIONS            = program.get<std::vector<std::string>>("--mentions");
     IS_DISPLAY          = program.get<bool>("--display");
     DISPLAY_LENGTH      = program.get<unsigned int>("--display-length");
+    JOURNAL_PATH        = program.get<std::string>("--journal");
+    IS_RESUME           = program.get<bool>("--resume");
+    IS_BULK_DELETE      = program.get<bool>("--bulk");
+    IMPORT_PATH         = program.get<std::string>("--import");
+    PLAN_PATH           = plan;
+    EXECUTE_PLAN_PATH   = execute_plan;
+    METRICS_PATH        = program.get<std::string>("--metrics");
+    ARCHIVE_PATH        = archive;
+    RECORD_PATH         = program.get<std::string>("--record");
+    REPLAY_PATH         = program.get<std::string>("--replay");
+    IS_REPLAY_FAST      = program.get<bool>("--replay-fast");
+    IS_PROGRESS         = !program.get<bool>("--no-progress");
+    JOBS_PATH           = jobs;
     BEFORE_DATE         = !before_date.empty() ? convert_to_snowflake_id(before_date) : "";
     DURING_DATE         = !during_date.empty() ? convert_to_snowflake_id(during_date) : "";
     AFTER_DATE          = !after_date.empty() ? convert_to_snowflake_id(after_date) : "";
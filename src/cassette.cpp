@@ -0,0 +1,233 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/cassette.hpp>
+#include <include/logger.hpp>
+#include <include/config.hpp>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+using nlohmann::json;
+
+namespace {
+    // Clears what would make the rate limiter wait, the recorded limits stay
+    void drop_waits(Response& response) {
+        for (auto& [name, value] : response.headers)
+            if (name == "x-ratelimit-reset-after" || name == "retry-after") value = "0";
+
+        auto body = json::parse(response.body, nullptr, false);
+        if (!body.is_discarded() && body.is_object() && body.contains("retry_after")) {
+            body["retry_after"] = 0;
+            response.body = body.dump();
+        }
+    }
+
+    // Splits a search URL into the search without its snowflake range, and the range. Returns false for other URLs.
+    bool split_search(const std::string_view url, std::string& search, uint64_t& min_id, uint64_t& max_id) {
+        const auto query = url.find("/messages/search?");
+        if (query == std::string_view::npos) return false;
+
+        min_id = 0;
+        max_id = UINT64_MAX;
+        std::string_view rest = url.substr(url.find('?') + 1);
+        search.assign(url.substr(0, url.size() - rest.size()));
+        bool is_first = true;
+        while (!rest.empty()) {
+            const auto end = rest.find('&');
+            const std::string_view param = rest.substr(0, end);
+            rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+
+            if (param.starts_with("min_id=")) std::from_chars(param.data() + 7, param.data() + param.size(), min_id);
+            else if (param.starts_with("max_id=")) std::from_chars(param.data() + 7, param.data() + param.size(), max_id);
+            else {
+                if (!is_first) search += '&';
+                search += param;
+                is_first = false;
+            }
+        }
+        return true;
+    }
+
+    Response not_recorded() {
+        Response response;
+        response.http_code = 404;
+        response.body = R"({"message": "Not in the recording", "code": 0})";
+        return response;
+    }
+}
+
+// Recordings do not depend on `--api-url`
+std::string_view Cassette::relative_url(std::string_view url) const {
+    if (url.starts_with(api_url)) url.remove_prefix(api_url.size());
+    return url;
+}
+
+std::string Cassette::route_key(const std::string_view method, const std::string_view url) const {
+    std::string key(method);
+    key += ' ';
+    key += relative_url(url);
+    return key;
+}
+
+void Cassette::record_to(const std::string& dir, const std::string& api_url) {
+    std::filesystem::create_directories(dir);
+    const auto path = std::filesystem::path(dir) / FILE_NAME;
+    out.open(path, std::ios::trunc);
+    if (!out) throw std::runtime_error("Failed to open `" + path.string() + "`.");
+    this->api_url = api_url;
+    mode = Mode::RECORD;
+}
+
+void Cassette::replay_from(const std::string& dir, const std::string& api_url, const bool is_fast) {
+    const auto path = std::filesystem::path(dir) / FILE_NAME;
+    std::ifstream in(path);
+    if (!in) throw std::invalid_argument("Recording `" + path.string() + "` does not exist.");
+
+    this->api_url = api_url;
+    exchanges.clear();
+    hits.clear();
+    std::string line;
+    for (size_t number = 1; std::getline(in, line); ++number) {
+        if (line.empty()) continue;
+        try {
+            const json record = json::parse(line);
+            Exchange exchange;
+            exchange.body = record.value("body", "");
+            Response& response = exchange.response;
+            response.result = static_cast<CURLcode>(record.value("result", 0));
+            response.http_code = record.at("status").get<long>();
+            response.body = record.value("response", "");
+            response.elapsed = std::chrono::microseconds(record.value("elapsed_us", int64_t{0}));
+            response.bytes = record.value("bytes", uint64_t{0});
+            for (const auto& header : record.value("headers", json::array()))
+                response.headers.emplace_back(header.at(0).get<std::string>(), header.at(1).get<std::string>());
+            if (is_fast) drop_waits(response);
+
+            const auto url = record.at("url").get<std::string>();
+            std::string search;
+            uint64_t min_id = 0, max_id = 0;
+            if (response.http_code == 200 && split_search(url, search, min_id, max_id)) add_hits(search, response.body);
+
+            exchanges[route_key(record.at("method").get<std::string>(), url)].push_back(std::move(exchange));
+        } catch (const json::exception& e) {
+            throw std::invalid_argument("Line " + std::to_string(number) + " of `" + path.string() + "` is not an exchange: " + e.what());
+        }
+    }
+
+    for (auto& [_, results] : hits) { // A message is usually found by more than one search
+        std::ranges::sort(results, std::greater{}, &Hit::id);
+        const auto duplicates = std::ranges::unique(results, {}, &Hit::id);
+        results.erase(duplicates.begin(), duplicates.end());
+    }
+
+    fast = is_fast;
+    replayed_count = searched_count = missed_count = 0;
+    mode = Mode::REPLAY;
+}
+
+void Cassette::record(const std::string_view method, const std::string_view url, const std::string_view body, const Response& response) {
+    json headers = json::array();
+    for (const auto& [name, value] : response.headers)
+        if (name != "set-cookie") headers.push_back({name, value});
+
+    json record = {
+        {"method", method},
+        {"url", relative_url(url)},
+        {"status", response.http_code},
+        {"result", static_cast<int>(response.result)},
+        {"elapsed_us", response.elapsed.count()},
+        {"bytes", response.bytes},
+        {"headers", std::move(headers)},
+        {"response", response.body}
+    };
+    if (!body.empty()) record["body"] = body;
+
+    const std::string line = record.dump(-1, ' ', false, json::error_handler_t::replace) + '\n';
+    std::scoped_lock lock(mutex);
+    out << line;
+    out.flush(); // A run killed by a second Ctrl-C keeps what it has sent
+}
+
+Response Cassette::replay(const std::string_view method, const std::string_view url, const std::string_view body) {
+    std::unique_lock lock(mutex);
+    const auto it = exchanges.find(route_key(method, url));
+    if (it == exchanges.end() || it->second.empty()) {
+        std::string query;
+        uint64_t min_id = 0, max_id = 0;
+        Response response;
+        if (split_search(relative_url(url), query, min_id, max_id) && search(query, min_id, max_id, response)) {
+            ++searched_count;
+            return response;
+        }
+
+        ++missed_count;
+        lock.unlock();
+        verbose(WARNING, "Replay: {} {} is not in the recording.", method, relative_url(url));
+        return not_recorded();
+    }
+
+    auto& queue = it->second;
+    auto match = queue.begin();
+    while (match != queue.end() && match->body != body) ++match;
+    if (match == queue.end()) match = queue.begin();
+
+    Response response = std::move(match->response);
+    queue.erase(match);
+    ++replayed_count;
+    return response;
+}
+
+void Cassette::add_hits(const std::string& search, const std::string& body) {
+    const auto page = json::parse(body, nullptr, false);
+    if (page.is_discarded() || !page.is_object()) return;
+
+    auto& results = hits[search];
+    for (const auto& group : page.value("messages", json::array())) {
+        if (!group.is_array() || group.empty() || !group[0].is_object()) continue;
+        const auto id = group[0].find("id");
+        if (id == group[0].end() || !id->is_string()) continue;
+
+        Hit hit;
+        const auto& text = id->get_ref<const std::string&>();
+        std::from_chars(text.data(), text.data() + text.size(), hit.id);
+        hit.group = group.dump();
+        results.push_back(std::move(hit));
+    }
+}
+
+// A page of the recorded results within the exclusive range, newest first, like the search returns them.
+bool Cassette::search(const std::string& search, const uint64_t min_id, const uint64_t max_id, Response& response) {
+    const auto it = hits.find(search);
+    if (it == hits.end()) return false;
+
+    unsigned int total = 0;
+    std::string messages;
+    for (const Hit& hit : it->second) {
+        if (hit.id >= max_id) continue;
+        if (hit.id <= min_id) break;
+        if (total++ >= PAGE_LIMIT) continue;
+        if (!messages.empty()) messages += ',';
+        messages += hit.group;
+    }
+
+    response = {};
+    response.http_code = 200;
+    response.body = R"({"total_results":)" + std::to_string(total) + R"(,"messages":[)" + messages + "]}";
+    return true;
+}
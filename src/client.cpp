@@ -0,0 +1,324 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/client.hpp>
+#include <include/helpers.hpp>
+#include <include/cassette.hpp>
+#include <curl/curl.h>
+#include <string>
+#include <string_view>
+#include <mutex>
+#include <array>
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <stdexcept>
+#include <chrono>
+#include <memory>
+#include <initializer_list>
+#include <utility>
+#include <thread>
+
+namespace {
+    const std::string DISCORD_API_AUTHORIZATION_KEY = "Authorization: ";
+    const std::string JSON_CONTENT_TYPE = "Content-Type: application/json";
+    constexpr size_t RESPONSE_BUFFER_SIZE = 64 * 1024; // A full search page is usually smaller
+    constexpr size_t MAX_RESERVED_BODY = 4 * 1024 * 1024; // Content-Length is not trusted beyond this, the body grows as it arrives
+    constexpr long CONNECT_TIMEOUT_S = 10;
+    constexpr long LOW_SPEED_LIMIT = 1;   // Bytes per second...
+    constexpr long LOW_SPEED_TIME_S = 30; // ...for this long and the transfer times out, which is retried (see `RetryPolicy`)
+
+    using ShareLocks = std::array<std::mutex, CURL_LOCK_DATA_LAST>;
+
+    void lock_share(CURL*, const curl_lock_data data, curl_lock_access, void* locks) {
+        (*static_cast<ShareLocks*>(locks))[data].lock();
+    }
+
+    void unlock_share(CURL*, const curl_lock_data data, void* locks) {
+        (*static_cast<ShareLocks*>(locks))[data].unlock();
+    }
+
+    size_t header_callback(char* buffer, size_t size, size_t nitems, void* userdata) {
+        // Called once per header line, e.g. "X-RateLimit-Remaining: 4\r\n"
+        const size_t length = size * nitems;
+        const std::string_view line(buffer, length);
+        const auto colon = line.find(':');
+        if (colon == std::string_view::npos) return length; // Status line or the blank line at the end
+
+        std::string name(line.substr(0, colon));
+        std::ranges::transform(name, name.begin(), [](const unsigned char c) { return std::tolower(c); });
+
+        auto value = line.substr(colon + 1);
+        while (!value.empty() && std::isspace(static_cast<unsigned char>(value.front()))) value.remove_prefix(1);
+        while (!value.empty() && std::isspace(static_cast<unsigned char>(value.back()))) value.remove_suffix(1);
+
+        auto* response = static_cast<Response*>(userdata);
+        if (name == "content-length") { // Size the receive buffer once instead of growing it while receiving
+            size_t body_length = 0;
+            std::from_chars(value.data(), value.data() + value.size(), body_length);
+            response->body.reserve(std::min(body_length, MAX_RESERVED_BODY));
+        }
+
+        response->headers.emplace_back(std::move(name), value);
+        return length;
+    }
+
+    // Called by libcurl about once a second and whenever data moves. A non-zero return aborts the transfer.
+    int progress_callback(void* cancelled, curl_off_t, curl_off_t, curl_off_t, curl_off_t) {
+        return static_cast<const std::atomic<bool>*>(cancelled)->load(std::memory_order_relaxed) ? 1 : 0;
+    }
+
+    void configure(CURL* curl, CURLSH* sh, curl_slist* headers, Response& response, const std::atomic<bool>& cancelled) {
+        // Options that never change between requests are set once, when the handle is created
+        if (sh) curl_easy_setopt(curl, CURLOPT_SHARE, sh);
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response.body);
+        curl_easy_setopt(curl, CURLOPT_HEADERFUNCTION, header_callback);
+        curl_easy_setopt(curl, CURLOPT_HEADERDATA, &response);
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_2TLS);
+        curl_easy_setopt(curl, CURLOPT_PIPEWAIT, 1L); // Wait for a multiplexed connection instead of opening another one
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, CONNECT_TIMEOUT_S);
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, LOW_SPEED_LIMIT);
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, LOW_SPEED_TIME_S);
+        curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+        curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, progress_callback);
+        curl_easy_setopt(curl, CURLOPT_XFERINFODATA, const_cast<std::atomic<bool>*>(&cancelled));
+
+        response.body.reserve(RESPONSE_BUFFER_SIZE);
+    }
+
+    void prepare(CURL* curl, Response& response, const std::string& url, const std::string& method, const std::string_view body) {
+        response.body.clear(); // Keeps the capacity of the previous response
+        response.http_code = 0;
+        response.headers.clear();
+
+        if (body.empty()) {
+            curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L); // Drops the body of a previous request
+        } else {
+            curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, static_cast<long>(body.size()));
+            curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, body.data());
+        }
+        curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method.c_str());
+    }
+
+    void finish(CURL* curl, const CURLcode result, Response& response) {
+        curl_off_t total_us = 0, downloaded = 0, uploaded = 0;
+        long header_size = 0, request_size = 0;
+
+        response.result = result;
+        curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &response.http_code);
+        curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total_us);
+        curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &downloaded);
+        curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &uploaded);
+        curl_easy_getinfo(curl, CURLINFO_HEADER_SIZE, &header_size);
+        curl_easy_getinfo(curl, CURLINFO_REQUEST_SIZE, &request_size);
+
+        response.elapsed = std::chrono::microseconds(total_us);
+        response.bytes = static_cast<uint64_t>(downloaded + uploaded + header_size + request_size);
+    }
+
+    curl_slist* authorization_headers(const std::string& token) {
+        curl_slist* headers = curl_slist_append(nullptr, (DISCORD_API_AUTHORIZATION_KEY + token).c_str());
+        if (!headers) return nullptr;
+
+        curl_slist* with_type = curl_slist_append(headers, JSON_CONTENT_TYPE.c_str());
+        if (!with_type) curl_slist_free_all(headers);
+        return with_type;
+    }
+}
+
+ConnectionPool::ConnectionPool() {
+    static const CURLcode initialized = curl_global_init(CURL_GLOBAL_DEFAULT); // Once per process, before the first handle
+    if (initialized != CURLE_OK) throw std::runtime_error("Failed to initialize HTTP client.");
+
+    try {
+        init(client_share, {CURL_LOCK_DATA_DNS, CURL_LOCK_DATA_SSL_SESSION, CURL_LOCK_DATA_CONNECT});
+        init(transfer_share, {CURL_LOCK_DATA_DNS, CURL_LOCK_DATA_SSL_SESSION});
+    } catch (...) {
+        curl_share_cleanup(client_share.handle);
+        throw;
+    }
+}
+
+ConnectionPool::~ConnectionPool() {
+    curl_share_cleanup(client_share.handle);
+    curl_share_cleanup(transfer_share.handle);
+}
+
+void ConnectionPool::init(Share& share, const std::initializer_list<curl_lock_data> data) {
+    share.handle = curl_share_init();
+    if (!share.handle) throw std::runtime_error("Failed to initialize HTTP client.");
+    curl_share_setopt(share.handle, CURLSHOPT_LOCKFUNC, lock_share);
+    curl_share_setopt(share.handle, CURLSHOPT_UNLOCKFUNC, unlock_share);
+    curl_share_setopt(share.handle, CURLSHOPT_USERDATA, &share.locks);
+    for (const curl_lock_data d : data) curl_share_setopt(share.handle, CURLSHOPT_SHARE, d);
+}
+
+std::string_view Response::header(const std::string_view name) const {
+    for (const auto& [key, value] : headers)
+        if (key == name) return value;
+    return {};
+}
+
+Client::Client(const std::string& token, ConnectionPool& pool, Cassette& cassette, const std::atomic<bool>& cancelled) : cassette(cassette) {
+    curl = curl_easy_init();
+    if (!curl) throw std::runtime_error("Failed to initialize HTTP client.");
+
+    headers = authorization_headers(token);
+    if (!headers) {
+        curl_easy_cleanup(curl);
+        throw std::runtime_error("Failed to initialize HTTP client.");
+    }
+
+    configure(curl, pool.clients(), headers, response, cancelled);
+}
+
+Client::~Client() {
+    curl_easy_cleanup(curl);
+    curl_slist_free_all(headers);
+}
+
+const Response& Client::request(const std::string& url, const std::string& method, const std::string_view body) {
+    if (cassette.is_replaying()) {
+        response = cassette.replay(method, url, body);
+        if (!cassette.is_fast()) std::this_thread::sleep_for(response.elapsed);
+        return response;
+    }
+
+    prepare(curl, response, url, method, body);
+    finish(curl, curl_easy_perform(curl), response);
+
+    if (cassette.is_recording()) cassette.record(method, url, body, response);
+    return response;
+}
+
+Transport::Transport(const std::string& token, ConnectionPool& pool, Cassette& cassette, const std::atomic<bool>& cancelled)
+    : pool(pool), cassette(cassette), cancelled(cancelled) {
+    multi = curl_multi_init();
+    headers = authorization_headers(token);
+    if (!multi || !headers) {
+        if (multi) curl_multi_cleanup(multi);
+        curl_slist_free_all(headers);
+        throw std::runtime_error("Failed to initialize HTTP client.");
+    }
+
+    curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+    curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS, MAX_CONNECTIONS);
+}
+
+Transport::~Transport() {
+    for (auto& [curl, _] : active) {
+        curl_multi_remove_handle(multi, curl);
+        curl_easy_cleanup(curl);
+    }
+    for (const auto& transfer : idle) curl_easy_cleanup(transfer->curl);
+    curl_multi_cleanup(multi);
+    curl_slist_free_all(headers);
+}
+
+void Transport::submit(const std::string& url, const std::string& method, const std::string_view body, Callback on_done) {
+    if (cassette.is_replaying()) {
+        Response response = cassette.replay(method, url, body);
+        const auto delay = cassette.is_fast() ? std::chrono::microseconds::zero() : response.elapsed;
+        replays.push_back({std::chrono::steady_clock::now() + delay, std::move(response), std::move(on_done)});
+        return;
+    }
+
+    std::unique_ptr<Transfer> transfer;
+    if (!idle.empty()) {
+        transfer = std::move(idle.back());
+        idle.pop_back();
+    } else {
+        transfer = std::make_unique<Transfer>();
+        transfer->curl = curl_easy_init();
+        if (!transfer->curl) throw std::runtime_error("Failed to initialize HTTP client.");
+        configure(transfer->curl, pool.transfers(), headers, transfer->response, cancelled); // The multi handle has its own connections
+    }
+
+    prepare(transfer->curl, transfer->response, url, method, body);
+    transfer->on_done = std::move(on_done);
+    if (cassette.is_recording()) {
+        transfer->method = method;
+        transfer->url = url;
+        transfer->body = body;
+    }
+
+    if (curl_multi_add_handle(multi, transfer->curl) != CURLM_OK) {
+        idle.push_back(std::move(transfer));
+        throw std::runtime_error("Failed to send request.");
+    }
+    active.emplace(transfer->curl, std::move(transfer));
+}
+
+void Transport::wakeup() {
+    curl_multi_wakeup(multi);
+}
+
+void Transport::poll(const std::chrono::milliseconds timeout) {
+    if (cassette.is_replaying()) {
+        poll_replays(timeout);
+        return;
+    }
+
+    int running = 0;
+    curl_multi_perform(multi, &running);
+    if (running > 0 || active.empty()) // Nothing finished yet, wait for the network (or just the timeout)
+        curl_multi_poll(multi, nullptr, 0, static_cast<int>(timeout.count()), nullptr);
+    curl_multi_perform(multi, &running);
+
+    int queued = 0;
+    while (const CURLMsg* msg = curl_multi_info_read(multi, &queued)) {
+        if (msg->msg != CURLMSG_DONE) continue;
+
+        CURL* curl = msg->easy_handle;
+        const CURLcode result = msg->data.result;
+        curl_multi_remove_handle(multi, curl);
+
+        const auto it = active.find(curl);
+        std::unique_ptr<Transfer> transfer = std::move(it->second);
+        active.erase(it);
+
+        finish(curl, result, transfer->response);
+        if (cassette.is_recording()) cassette.record(transfer->method, transfer->url, transfer->body, transfer->response);
+
+        const Callback on_done = std::move(transfer->on_done);
+        try {
+            on_done(transfer->response);
+        } catch (...) {
+            idle.push_back(std::move(transfer));
+            throw;
+        }
+        idle.push_back(std::move(transfer)); // Not before, the callback reads the response from it
+    }
+}
+
+void Transport::poll_replays(const std::chrono::milliseconds timeout) {
+    using clock = std::chrono::steady_clock;
+
+    // The multi handle has no transfers, but still waits for `wakeup`
+    const auto now = clock::now();
+    auto until = now + timeout;
+    for (const auto& replay : replays) until = std::min(until, replay.due);
+    if (until > now) {
+        const auto wait = std::chrono::ceil<std::chrono::milliseconds>(until - now);
+        curl_multi_poll(multi, nullptr, 0, static_cast<int>(wait.count()), nullptr);
+    }
+
+    // In the order they are due, like responses arriving from the network
+    while (true) {
+        const auto next = std::ranges::min_element(replays, {}, &Replay::due);
+        if (next == replays.end() || next->due > clock::now()) return;
+
+        Replay replay = std::move(*next);
+        replays.erase(next);
+        replay.on_done(replay.response);
+    }
+}
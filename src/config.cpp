@@ -9,6 +9,7 @@
 #include <include/config.hpp>
 #include <vector>
 
+std::string               DISCORD_API_URL_BASE = DISCORD_API_URL_BASE_DEFAULT;
 unsigned int              DELAY_IN_MS     = DELAY_IN_MS_DEFAULT;
 unsigned int              DISPLAY_LENGTH = 100;
 bool                      IS_VERBOSE      = false;
@@ -17,6 +18,9 @@ bool                      IS_NOCONFIRM    = false;
 bool                      IS_INTERACTIVE  = false;
 bool                      IS_SKIP_IF_FAIL = false;
 bool                      IS_DISPLAY      = false;
+bool                      IS_PROGRESS     = true;
+bool                      IS_RESUME       = false;
+bool                      IS_BULK_DELETE  = false;
 bool                      REMOVE_PINNED   = true;
 bool                      NO_LINK         = false;
 bool                      NO_EMBED        = false;
@@ -35,3 +39,14 @@ std::string               AFTER_DATE;
 std::string               SENDER_ID;
 std::string               GUILD_ID;
 std::string               CHANNEL_ID;
+std::string               JOURNAL_PATH;
+std::string               IMPORT_PATH;
+std::string               PLAN_PATH;
+std::string               EXECUTE_PLAN_PATH;
+std::string               METRICS_PATH;
+std::string               ARCHIVE_PATH;
+std::string               ARCHIVE_FIND;
+std::string               RECORD_PATH;
+std::string               REPLAY_PATH;
+bool                      IS_REPLAY_FAST  = false;
+std::string               JOBS_PATH;
@@ -0,0 +1,56 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/filter.hpp>
+#include <string_view>
+#include <utility>
+#include <algorithm>
+#include <cctype>
+
+FeatureSet option_feature(const std::string_view name) {
+    constexpr std::pair<std::string_view, Feature> options[] = {
+        {"poll", FEATURE_POLL}, {"embed", FEATURE_EMBED}, {"link", FEATURE_LINK}, {"file", FEATURE_FILE},
+        {"image", FEATURE_IMAGE}, {"video", FEATURE_VIDEO}, {"audio", FEATURE_AUDIO},
+        {"sticker", FEATURE_STICKER}, {"forward", FEATURE_FORWARD}
+    };
+
+    for (const auto& [option, feature] : options)
+        if (option == name) return feature;
+    return 0;
+}
+
+FeatureSet classify_attachment(const std::string_view content_type) {
+    if (content_type.starts_with("image")) return FEATURE_IMAGE;
+    if (content_type.starts_with("video")) return FEATURE_VIDEO;
+    if (content_type.starts_with("audio")) return FEATURE_AUDIO;
+    return content_type.empty() ? FEATURE_FILE : 0; // Any other content type has no feature of its own
+}
+
+FeatureSet classify_embed(const std::string_view type) {
+    return type == "link" ? FEATURE_EMBED | FEATURE_LINK : FEATURE_EMBED;
+}
+
+FeatureSet classify_attachment_url(std::string_view url) {
+    constexpr std::pair<std::string_view, Feature> extensions[] = {
+        {"png", FEATURE_IMAGE}, {"jpg", FEATURE_IMAGE}, {"jpeg", FEATURE_IMAGE}, {"gif", FEATURE_IMAGE}, {"webp", FEATURE_IMAGE},
+        {"mp4", FEATURE_VIDEO}, {"webm", FEATURE_VIDEO}, {"mov", FEATURE_VIDEO},
+        {"mp3", FEATURE_AUDIO}, {"ogg", FEATURE_AUDIO}, {"wav", FEATURE_AUDIO}, {"flac", FEATURE_AUDIO}, {"m4a", FEATURE_AUDIO}
+    };
+
+    url = url.substr(0, url.find('?')); // Signed CDN URLs carry a query string
+    const auto dot = url.rfind('.');
+    if (dot == std::string_view::npos || url.find('/', dot) != std::string_view::npos) return FEATURE_FILE;
+
+    const auto extension = url.substr(dot + 1);
+    for (const auto& [name, feature] : extensions) {
+        if (extension.size() == name.size()
+            && std::ranges::equal(extension, name, [](const unsigned char a, const char b) { return std::tolower(a) == b; }))
+            return feature;
+    }
+    return FEATURE_FILE;
+}
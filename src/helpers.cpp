@@ -8,13 +8,16 @@
 
 #include <include/helpers.hpp>
 #include <include/config.hpp>
-#include <curl/curl.h>
+#include <include/job.hpp>
 #include <string>
-#include <sstream>
-#include <iomanip>
+#include <string_view>
+#include <cstdint>
+#include <ctime>
+#include <stdexcept>
 #include <vector>
 #include <utility>
 #include <cctype>
+#include <algorithm>
 
 size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
     /*
@@ -27,110 +30,118 @@ size_t write_callback(void* contents, size_t size, size_t nmemb, void* userp) {
     return size * nmemb;
 }
 
-std::string url_encode(const std::string& value) {
+void url_encode(std::string& out, const std::string_view value) {
     /*
      * urlEncode is needed because URLs can only contain certain ASCII characters.
      * Characters like spaces, quotes, and special symbols must be converted into a safe, transmittable format (percent-encoding).
      * Without encoding, these characters could break the URL structure, cause errors, or introduce security vulnerabilities.
      * URL encoding ensures valid, consistent, and secure transmission of data in URLs across different browsers and servers.
      */
-    std::ostringstream escaped;
-
-    escaped.fill('0');
-    escaped << std::hex;
+    constexpr char HEX_DIGITS[] = "0123456789abcdef";
 
-    for (char c : value) {
-        if (isalnum(static_cast<unsigned char>(c)) || c == '-' || c == '_' || c == '.' || c == '~') {
-            escaped << c;
+    for (const char c : value) {
+        const auto u = static_cast<unsigned char>(c);
+        if (std::isalnum(u) || c == '-' || c == '_' || c == '.' || c == '~') {
+            out += c;
             continue;
         }
 
-        escaped << '%' << std::setw(2) << static_cast<int>(static_cast<unsigned char>(c));
+        const char escaped[3] = {'%', HEX_DIGITS[u >> 4], HEX_DIGITS[u & 0xF]};
+        out.append(escaped, sizeof(escaped));
     }
-    return escaped.str();
+}
+
+std::string url_encode(const std::string& value) {
+    std::string escaped;
+    escaped.reserve(value.size());
+    url_encode(escaped, value);
+    return escaped;
+}
+
+void append_query(std::string& query, const std::string_view key, const std::string_view value) {
+    if (value.empty()) return;
+
+    if (!query.empty() && query.back() != '?') query += '&';
+    url_encode(query, key);
+    query += '=';
+    url_encode(query, value);
 }
 
 std::string build_query_string(const std::vector<Query>& params) {
-    std::ostringstream oss;
-    bool first = true;
-    for (const auto& [key, value] : params) {
-        if (!value.empty()) {
-            if (!first) oss << "&";
-            oss << url_encode(key) << "=" << url_encode(value);
-            first = false;
-        }
-    }
-    return oss.str();
+    std::string query;
+    for (const auto& [key, value] : params) append_query(query, key, value);
+    return query;
 }
 
-std::vector<Query> construct_query_params(const std::string& offset) {
-    constexpr unsigned long long int SNOWFLAKE_ID_1_DAY = 362387865600000ULL;
+std::string build_search_query(const JobConfig& job) {
+    // The snowflake range changes between pages (see `search_range`), so it is appended by the caller.
+    std::string query;
+    append_query(query, "author_id", job.sender_id);
+    append_query(query, "channel_id", job.channel_id);
+    append_query(query, "limit", std::to_string(PAGE_LIMIT));
+    append_query(query, "sort_by", "timestamp");
+    append_query(query, "sort_order", "desc"); // Newest first, pages are walked from the newest message to the oldest
 
-    std::vector<Query> params = {
-        {"author_id", SENDER_ID},
-        {"channel_id", CHANNEL_ID},
-        {"offset", offset},
-        {"limit", std::to_string(PAGE_LIMIT)}
-    };
+    for (const auto& mention : job.mentions) append_query(query, "mentions", mention);
 
-    if (!MENTIONS.empty()) {
-        for (const auto& mention : MENTIONS) params.emplace_back("mentions", mention);
-    }
+    if (!job.remove_pinned) append_query(query, "pinned", "false");
+    // The `has` parameter will be processed during parsing.
+
+    return query;
+}
 
-    if (!REMOVE_PINNED) params.emplace_back("pinned", "false");
+SnowflakeRange search_range(const JobConfig& job) {
+    constexpr unsigned long long int SNOWFLAKE_ID_1_DAY = 362387865600000ULL;
+    SnowflakeRange range;
 
-    if (!BEFORE_DATE.empty()) {
-        params.emplace_back("max_id", BEFORE_DATE);
+    if (!job.before_date.empty()) {
+        range.max_id = std::min<uint64_t>(range.max_id, std::stoull(job.before_date));
     }
-    if (!AFTER_DATE.empty()) {
-        params.emplace_back("min_id", std::to_string(std::stoull(AFTER_DATE) + SNOWFLAKE_ID_1_DAY));
+    if (!job.after_date.empty()) {
+        range.min_id = std::max<uint64_t>(range.min_id, std::stoull(job.after_date) + SNOWFLAKE_ID_1_DAY);
     }
-    if (!DURING_DATE.empty()) {
-        params.emplace_back("min_id", DURING_DATE);
-        params.emplace_back("max_id", std::to_string(std::stoull(DURING_DATE) + SNOWFLAKE_ID_1_DAY));
+    if (!job.during_date.empty()) {
+        range.min_id = std::max<uint64_t>(range.min_id, std::stoull(job.during_date));
+        range.max_id = std::min<uint64_t>(range.max_id, std::stoull(job.during_date) + SNOWFLAKE_ID_1_DAY);
     }
-    // The `has` parameter will be processed during parsing.
 
-    return params;
+    return range;
 }
 
-std::string convert_to_snowflake_id(const std::string& iso8601) {
-    // Discord uses its own timestamp system instead of the traditional Unix timestamps
-    constexpr unsigned long long int DISCORD_EPOCH = 1420070400000ULL;
+uint64_t date_to_snowflake(const std::string_view iso8601) {
+    // YYYY-MM-DD, anything after the date (e.g. a time) is ignored
+    constexpr size_t MAX_DIGITS[3] = {4, 2, 2};
+    int fields[3] = {}; // Year, month, day
+    size_t pos = 0;
 
-    std::tm tm = {};
-    std::istringstream ss(iso8601);
+    for (size_t f = 0; f < 3; ++f) {
+        if (f > 0) {
+            if (pos >= iso8601.size() || iso8601[pos] != '-') throw std::runtime_error("Failed to parse ISO8601 date");
+            ++pos;
+        }
+        const size_t start = pos;
+        while (pos < iso8601.size() && pos - start < MAX_DIGITS[f] && std::isdigit(static_cast<unsigned char>(iso8601[pos])))
+            fields[f] = fields[f] * 10 + (iso8601[pos++] - '0');
+        if (pos == start) throw std::runtime_error("Failed to parse ISO8601 date");
+    }
+    if (fields[1] < 1 || fields[1] > 12 || fields[2] < 1 || fields[2] > 31)
+        throw std::runtime_error("Failed to parse ISO8601 date");
 
-    ss >> std::get_time(&tm, "%Y-%m-%d");
-    if (ss.fail()) throw std::runtime_error("Failed to parse ISO8601 date");
+    // Midnight in local time, as before
+    std::tm tm = {};
+    tm.tm_year = fields[0] - 1900;
+    tm.tm_mon = fields[1] - 1;
+    tm.tm_mday = fields[2];
     tm.tm_isdst = -1;
 
     const std::time_t time = std::mktime(&tm);
     if (time == -1) throw std::runtime_error("Failed to parse ISO8601 date");
 
-    const auto time_point = std::chrono::system_clock::from_time_t(time);
-    const auto ms_since_epoch = std::chrono::duration_cast<std::chrono::milliseconds>(time_point.time_since_epoch()).count();
-    const unsigned long long int timestamp = ms_since_epoch - DISCORD_EPOCH;
-    const unsigned long long int snowflake = timestamp << 22;
-
-    return std::to_string(snowflake);
+    const auto ms_since_epoch = static_cast<uint64_t>(static_cast<int64_t>(time) * 1000);
+    const uint64_t timestamp = ms_since_epoch - DISCORD_EPOCH;
+    return timestamp << 22;
 }
 
-std::pair<CURL*, CURLcode> send_request(std::string& response,
-                                       const std::string& _headers,
-                                       const std::string& url,
-                                       const std::string& method) {
-    CURL* curl = curl_easy_init();
-    if (!curl) throw std::runtime_error("Failed to send request.");
-    struct curl_slist* headers = nullptr;
-    headers = curl_slist_append(headers, _headers.c_str());
-    curl_easy_setopt(curl, CURLOPT_URL, url.c_str());
-    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
-    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
-    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
-    curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, method.c_str());
-    CURLcode result = curl_easy_perform(curl);
-    curl_slist_free_all(headers);
-
-    return {curl, result};
+std::string convert_to_snowflake_id(const std::string& iso8601) {
+    return std::to_string(date_to_snowflake(iso8601));
 }
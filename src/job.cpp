@@ -0,0 +1,135 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/job.hpp>
+#include <include/filter.hpp>
+#include <include/plan.hpp>
+#include <include/helpers.hpp>
+#include <nlohmann/json.hpp>
+#include <fmt/format.h>
+#include <exception>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using nlohmann::json;
+
+std::string run_header(const JobConfig& job) {
+    std::string header = job.guild_id + ' ' + job.channel_id + ' ' + job.sender_id + ' '
+                       + job.before_date + ' ' + job.during_date + ' ' + job.after_date + ' '
+                       + std::to_string(job.rules) + ' ' + (job.remove_pinned ? '1' : '0') + ' ';
+    for (size_t i = 0; i < job.mentions.size(); ++i) {
+        if (i) header += ',';
+        header += job.mentions[i];
+    }
+    return header;
+}
+
+std::string default_job_name(const JobConfig& job) {
+    return job.channel_id.empty() ? job.guild_id : job.guild_id + '/' + job.channel_id;
+}
+
+namespace {
+    // Sets the option `key` of a manifest job.
+    void apply_option(JobConfig& job, const std::string& key, const json& value) {
+        const auto text = [&] {
+            if (!value.is_string()) throw std::invalid_argument("`" + key + "` must be a string.");
+            return value.get<std::string>();
+        };
+        const auto flag = [&] {
+            if (!value.is_boolean()) throw std::invalid_argument("`" + key + "` must be true or false.");
+            return value.get<bool>();
+        };
+        const auto date = [&] {
+            const std::string iso8601 = text();
+            return iso8601.empty() ? iso8601 : convert_to_snowflake_id(iso8601);
+        };
+
+        if (key == "name") job.name = text();
+        else if (key == "sender-id") job.sender_id = text();
+        else if (key == "guild-id") job.guild_id = text();
+        else if (key == "channel-id") job.channel_id = text();
+        else if (key == "mentions") {
+            if (!value.is_array()) throw std::invalid_argument("`mentions` must be an array of user IDs.");
+            job.mentions.clear();
+            for (const auto& id : value) {
+                if (!id.is_string()) throw std::invalid_argument("`mentions` must be an array of user IDs.");
+                job.mentions.push_back(id.get<std::string>());
+            }
+        }
+        else if (key == "before-date") job.before_date = date();
+        else if (key == "during-date") job.during_date = date();
+        else if (key == "after-date") job.after_date = date();
+        else if (key == "journal") job.journal_path = text();
+        else if (key == "resume") job.resume = flag();
+        else if (key == "import") job.import_path = text();
+        else if (key == "plan") job.plan_path = text();
+        else if (key == "execute-plan") job.execute_plan_path = text();
+        else if (key == "skip-if-fail") job.skip_if_fail = flag();
+        else if (key == "bulk") job.bulk_delete = flag();
+        else if (key == "no-pinned") job.remove_pinned = !flag();
+        else if (const FeatureSet feature = key.starts_with("no-") ? option_feature(std::string_view(key).substr(3)) : 0) {
+            if (flag()) job.rules |= feature;
+            else job.rules &= static_cast<FeatureSet>(~feature);
+        }
+        else throw std::invalid_argument("unknown option `" + key + "`.");
+    }
+
+    // The checks `process_arguments` does for the command line.
+    void validate(const JobConfig& job) {
+        if (job.sender_id.empty()) throw std::invalid_argument("`sender-id` is required.");
+        if (job.guild_id.empty()) throw std::invalid_argument("`guild-id` is required.");
+        if (job.channel_id.empty() && is_dm_guild(job.guild_id)) throw std::invalid_argument("`channel-id` is required for DMs.");
+        if (job.resume && job.journal_path.empty()) throw std::invalid_argument("`resume` requires `journal`.");
+        if (!job.plan_path.empty() && !job.execute_plan_path.empty())
+            throw std::invalid_argument("`plan` and `execute-plan` cannot be used together.");
+        if (!job.plan_path.empty() && !job.journal_path.empty()) throw std::invalid_argument("`plan` deletes nothing, so it has no journal.");
+        if (!job.execute_plan_path.empty() && !job.import_path.empty())
+            throw std::invalid_argument("`execute-plan` and `import` cannot be used together.");
+    }
+}
+
+std::vector<JobConfig> read_job_manifest(const std::string& path, const JobConfig& defaults) {
+    std::ifstream in(path);
+    if (!in) throw std::invalid_argument("Job manifest `" + path + "` does not exist.");
+
+    const json manifest = json::parse(in, nullptr, false);
+    if (manifest.is_discarded() || !manifest.is_array() || manifest.empty())
+        throw std::invalid_argument("`" + path + "` is not a job manifest (a JSON array of jobs).");
+
+    std::vector<JobConfig> jobs;
+    for (const auto& entry : manifest) {
+        const size_t number = jobs.size() + 1;
+        JobConfig job = defaults;
+        job.name.clear();
+
+        try {
+            if (!entry.is_object()) throw std::invalid_argument("not an object.");
+            for (const auto& [key, value] : entry.items()) apply_option(job, key, value);
+            if (!job.execute_plan_path.empty()) apply_plan_header(job.execute_plan_path, job);
+            validate(job);
+        } catch (const std::exception& e) {
+            throw std::invalid_argument(fmt::format("Job {} of `{}`: {}", number, path, e.what()));
+        }
+
+        // Two jobs appending to the same file would corrupt it
+        for (size_t i = 0; i < jobs.size(); ++i) {
+            for (const auto& [mine, theirs] : {std::pair{&job.journal_path, &jobs[i].journal_path}, {&job.plan_path, &jobs[i].plan_path}}) {
+                if (!mine->empty() && *mine == *theirs)
+                    throw std::invalid_argument(fmt::format("Jobs {} and {} of `{}` both write to `{}`.", i + 1, number, path, *mine));
+            }
+        }
+
+        if (job.name.empty()) job.name = default_job_name(job);
+        jobs.push_back(std::move(job));
+    }
+    return jobs;
+}
@@ -0,0 +1,144 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/journal.hpp>
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <iterator>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+namespace {
+    constexpr unsigned int JOURNAL_BATCH_SIZE = 64; // Records per write
+
+    bool parse_id(const std::string_view s, uint64_t& id) {
+        const auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), id);
+        return ec == std::errc() && end == s.data() + s.size();
+    }
+}
+
+Journal::Journal(const std::string& path, const bool resume, std::string header) : header(std::move(header)) {
+    if (resume) read(path);
+
+    file.open(path, resume ? std::ios::app : std::ios::trunc);
+    if (!file) throw std::runtime_error("Failed to open journal `" + path + "`.");
+
+    if (!resume) {
+        file << "H " << this->header << '\n';
+        file.flush();
+    }
+}
+
+Journal::~Journal() {
+    flush();
+}
+
+void Journal::read(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) throw std::invalid_argument("Cannot resume: journal `" + path + "` does not exist.");
+
+    std::vector<SnowflakeRange> pages;
+    std::unordered_set<uint64_t> unresolved; // Queued, but not deleted
+    std::string line;
+
+    while (std::getline(in, line)) {
+        if (line.size() < 3 || line[1] != ' ') continue; // Torn write
+        const std::string_view rest = std::string_view(line).substr(2);
+
+        if (line[0] == 'H') {
+            if (rest != header) throw std::invalid_argument("Cannot resume: the journal belongs to a different guild, channel, sender, filter or date range.");
+            continue;
+        }
+
+        const size_t space = rest.find(' ');
+        uint64_t id = 0;
+        if (!parse_id(rest.substr(0, space), id)) continue;
+
+        switch (line[0]) {
+            case 'P': {
+                uint64_t min_id = 0;
+                if (space != std::string_view::npos && parse_id(rest.substr(space + 1), min_id)) pages.push_back({min_id, id});
+                break;
+            }
+            case 'Q': unresolved.insert(id); break;
+            case 'S': resumed.done.insert(id); break;
+            case 'D':
+                if (resumed.done.insert(id)) resumed.deleted.push_back(id);
+                unresolved.erase(id);
+                break;
+            case 'F': break; // Stays unresolved, so its page is searched again and the message retried
+            default: break;
+        }
+    }
+
+    /*
+     * Pages never overlap (see `ShardQueue`). A page with a message that was queued but never finished
+     * is searched again, every other page is done.
+     */
+    std::ranges::sort(pages, {}, &SnowflakeRange::min_id);
+    std::vector<bool> is_unfinished(pages.size());
+    for (const uint64_t id : unresolved) {
+        const auto it = std::ranges::lower_bound(pages, id, {}, &SnowflakeRange::min_id); // First page starting at or above the message
+        if (it != pages.begin() && id < std::prev(it)->max_id) is_unfinished[static_cast<size_t>(std::prev(it) - pages.begin())] = true;
+    }
+    for (size_t i = 0; i < pages.size(); ++i)
+        if (!is_unfinished[i]) resumed.searched.push_back(pages[i]);
+}
+
+void Journal::page(const SnowflakeRange& searched) {
+    char digits[20];
+    const auto [end, _] = std::to_chars(digits, digits + sizeof(digits), searched.min_id);
+    append('P', searched.max_id, std::string_view(digits, static_cast<size_t>(end - digits)));
+}
+void Journal::queued(const uint64_t id) { append('Q', id); }
+void Journal::skipped(const uint64_t id) { append('S', id); }
+void Journal::deleted(const uint64_t id) { append('D', id); }
+
+void Journal::failed(const uint64_t id, const std::string_view reason) {
+    std::string single_line(reason);
+    std::ranges::replace(single_line, '\n', ' ');
+    append('F', id, single_line);
+}
+
+void Journal::flush() {
+    std::scoped_lock lock(mutex);
+    write_pending();
+}
+
+void Journal::append(const char kind, const uint64_t value, const std::string_view extra) {
+    std::scoped_lock lock(mutex);
+    char digits[20];
+    const auto [end, _] = std::to_chars(digits, digits + sizeof(digits), value);
+
+    pending += kind;
+    pending += ' ';
+    pending.append(digits, end);
+    if (!extra.empty()) {
+        pending += ' ';
+        pending += extra;
+    }
+    pending += '\n';
+
+    if (++pending_records >= JOURNAL_BATCH_SIZE) write_pending();
+}
+
+void Journal::write_pending() {
+    if (pending.empty()) return;
+
+    file.write(pending.data(), static_cast<std::streamsize>(pending.size()));
+    file.flush();
+    pending.clear();
+    pending_records = 0;
+}
@@ -0,0 +1,175 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/logger.hpp>
+#include <fmt/base.h>
+#include <fmt/color.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+    constexpr size_t MAX_PENDING_LINES = 4096; // Beyond that, callers wait for the terminal instead of growing the buffer
+    constexpr const char* CLEAR_LINE = "\r\x1b[K";
+
+    std::atomic<bool> SINK_STARTED = false;
+    std::atomic<LogLevel> PROCESS_LOG_LEVEL = LogLevel::INFO;
+    thread_local std::optional<LogLevel> THREAD_LOG_LEVEL; // Set by `LogLevelScope`
+
+    void print(const MessageType type, const std::string& line) {
+        switch (type) {
+            case OK:
+                fmt::print("{}\n", line);
+                break;
+            case WARNING:
+                fmt::print(fg(fmt::color::yellow), "{}\n", line);
+                break;
+            case ERROR:
+                fmt::print(fg(fmt::color::red), "{}\n", line);
+                break;
+        }
+    }
+
+    class Sink {
+    public:
+        Sink() : thread([this] { run(); }) { SINK_STARTED = true; }
+
+        ~Sink() {
+            {
+                std::scoped_lock lock(mutex);
+                is_stopping = true;
+            }
+            ready.notify_one();
+            thread.join(); // Writes what is still pending first
+        }
+
+        void push(const MessageType type, std::string line) {
+            std::unique_lock lock(mutex);
+            has_space.wait(lock, [this] { return pending.size() < MAX_PENDING_LINES; });
+            pending.emplace_back(type, std::move(line));
+            ++pushed;
+            ready.notify_one();
+        }
+
+        void status(std::string line) {
+            std::scoped_lock lock(mutex);
+            status_line = std::move(line);
+            is_status_changed = true;
+            ++pushed; // Counted like a line, so `flush` waits for the status line to be drawn or removed
+            ready.notify_one();
+        }
+
+        void set_handler(LogHandler on_line) {
+            std::scoped_lock lock(mutex);
+            handler = std::move(on_line);
+            is_handler_changed = true;
+        }
+
+        void flush() {
+            std::unique_lock lock(mutex);
+            const uint64_t target = pushed;
+            written_up_to.wait(lock, [&] { return written >= target; });
+        }
+
+    private:
+        void run() {
+            std::vector<std::pair<MessageType, std::string>> batch;
+            std::string status;
+            LogHandler on_line;
+            bool is_status_shown = false;
+            std::unique_lock lock(mutex);
+            while (true) {
+                ready.wait(lock, [this] { return is_stopping || !pending.empty() || is_status_changed; });
+                if (pending.empty() && !is_status_changed) {
+                    if (is_status_shown) std::fputs(CLEAR_LINE, stdout);
+                    std::fflush(stdout);
+                    return;
+                }
+
+                batch.swap(pending); // Lines are written without holding the lock
+                const uint64_t count = pushed - written;
+                if (is_status_changed) status = status_line;
+                is_status_changed = false;
+                if (is_handler_changed) on_line = handler;
+                is_handler_changed = false;
+                lock.unlock();
+                has_space.notify_all();
+
+                // The status line is taken down, the log lines go above it, and it is drawn again below them
+                if (is_status_shown) std::fputs(CLEAR_LINE, stdout);
+                for (const auto& [type, line] : batch) {
+                    if (on_line) on_line(type, line);
+                    else print(type, line);
+                }
+                if (!status.empty()) std::fputs(status.c_str(), stdout);
+                is_status_shown = !status.empty();
+                std::fflush(stdout);
+
+                lock.lock();
+                written += count;
+                batch.clear();
+                written_up_to.notify_all();
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable ready, has_space, written_up_to;
+        std::vector<std::pair<MessageType, std::string>> pending;
+        std::string status_line;
+        bool is_status_changed = false;
+        LogHandler handler;
+        bool is_handler_changed = false;
+        uint64_t pushed = 0, written = 0;
+        bool is_stopping = false;
+        std::thread thread; // Last, so it starts once everything above is constructed
+    };
+
+    Sink& sink() {
+        static Sink instance;
+        return instance;
+    }
+}
+
+void set_log_level(const LogLevel level) {
+    PROCESS_LOG_LEVEL.store(level, std::memory_order_relaxed);
+}
+
+LogLevel log_level() {
+    return THREAD_LOG_LEVEL ? *THREAD_LOG_LEVEL : PROCESS_LOG_LEVEL.load(std::memory_order_relaxed);
+}
+
+LogLevelScope::LogLevelScope(const LogLevel level) : previous(THREAD_LOG_LEVEL) {
+    THREAD_LOG_LEVEL = level;
+}
+
+LogLevelScope::~LogLevelScope() {
+    THREAD_LOG_LEVEL = previous;
+}
+
+void write_log(const MessageType type, std::string line) {
+    sink().push(type, std::move(line));
+}
+
+void set_log_handler(LogHandler handler) {
+    sink().set_handler(std::move(handler));
+}
+
+void set_status(std::string line) {
+    sink().status(std::move(line));
+}
+
+void flush_log() {
+    if (SINK_STARTED) sink().flush();
+}
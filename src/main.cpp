@@ -9,11 +9,28 @@
 #include <include/arguments.hpp>
 #include <include/config.hpp>
 #include <include/remover.hpp>
+#include <include/job.hpp>
+#include <include/options.hpp>
+#include <include/metrics.hpp>
+#include <include/archive.hpp>
+#include <include/progress.hpp>
 #include <include/helpers.hpp>
+#include <include/logger.hpp>
 #include <fmt/base.h>
 #include <fmt/color.h>
+#include <atomic>
+#include <chrono>
 #include <string>
+#include <utility>
+#include <vector>
+#include <algorithm>
 #include <stdexcept>
+#include <csignal>
+
+constexpr auto TERMINAL_PROGRESS_INTERVAL = std::chrono::milliseconds(500); // Redraws of the status line
+constexpr auto LOG_PROGRESS_INTERVAL = std::chrono::seconds(10);          // Progress lines when the output is not a terminal
+
+std::atomic<Remover*> RUNNING_REMOVER = nullptr; // Cancelled by the signal handler
 
 void InteractiveSession() {
     bool is_verbose = false, is_debug = false;
@@ -22,7 +39,7 @@ void InteractiveSession() {
     ask("Enable verbose output? [y/n]: ", verbose_input);
     ask("Enable debug output (intended for development)? [y/n]: ", debug_input);
     input("Enter guild ID (or '@me' for DMs): ", guild_id);
-    input("Enter channel ID: ", channel_id);
+    input("Enter channel ID (empty for the whole guild): ", channel_id);
     input("Enter sender ID: ", sender_id);
 
     if (parse_input(verbose_input))
@@ -31,8 +48,8 @@ void InteractiveSession() {
         is_debug = true;
     if (guild_id.empty())
         throw std::invalid_argument("Guild ID is required.");
-    if (channel_id.empty())
-        throw std::invalid_argument("Channel ID is required.");
+    if (channel_id.empty() && is_dm_guild(guild_id))
+        throw std::invalid_argument("Channel ID is required for DMs.");
     if (sender_id.empty())
         throw std::invalid_argument("Sender ID is required.");
 
@@ -43,6 +60,73 @@ void InteractiveSession() {
     SENDER_ID = sender_id;
 }
 
+// Most detailed level asked for with `--verbose` or `--debug`.
+LogLevel cli_log_level() {
+    return IS_DEBUG ? LogLevel::DEBUG : IS_VERBOSE ? LogLevel::VERBOSE : LogLevel::INFO;
+}
+
+// The run given by the command line options.
+RemoverConfig remover_from_options(std::vector<JobConfig> jobs) {
+    RemoverConfig config;
+    config.jobs           = std::move(jobs);
+    config.token          = DISCORD_TOKEN;
+    config.api_url        = DISCORD_API_URL_BASE;
+    config.delay          = std::chrono::milliseconds(DELAY_IN_MS);
+    config.display        = IS_DISPLAY;
+    config.display_length = DISPLAY_LENGTH;
+    config.metrics_path   = METRICS_PATH;
+    config.archive_path   = ARCHIVE_PATH;
+    config.record_path    = RECORD_PATH;
+    config.replay_path    = REPLAY_PATH;
+    config.replay_fast    = IS_REPLAY_FAST;
+    config.log_level      = cli_log_level();
+
+    // A status line below the log on a terminal. Otherwise, e.g. when the output goes to a file, a plain log line now and then.
+    if (IS_PROGRESS) {
+        const bool is_terminal = is_terminal_output();
+        config.progress_interval = is_terminal ? TERMINAL_PROGRESS_INTERVAL : std::chrono::milliseconds(LOG_PROGRESS_INTERVAL);
+        config.on_progress = [is_terminal](const Progress& progress) {
+            std::string line = format_progress(progress);
+            if (is_terminal) set_status(std::move(line));
+            else info("Progress: {}", line);
+        };
+    }
+    return config;
+}
+
+// Prints the summaries of the `--plan` jobs.
+void print_plans(const std::vector<JobConfig>& jobs, const RunStats& stats) {
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        if (stats.jobs[i].plan_summary.empty()) continue;
+        if (jobs.size() > 1) fmt::print("{}:\n", jobs[i].name);
+        fmt::print("{}", stats.jobs[i].plan_summary);
+    }
+}
+
+// Prints how every job of a `--jobs` manifest ended, and returns the exit code.
+int report_jobs(const std::vector<JobConfig>& jobs, const RunStats& stats) {
+    bool is_failed = false;
+    for (size_t i = 0; i < jobs.size(); ++i) {
+        const JobStats& job = stats.jobs[i];
+        if (!job.error.empty()) {
+            fmt::print(fg(fmt::color::red), "Job `{}` failed: {}\n", jobs[i].name, job.error);
+            is_failed = true;
+        } else if (!jobs[i].plan_path.empty()) {
+            fmt::print("Job `{}`: {} messages planned in `{}`.\n", jobs[i].name, job.planned, jobs[i].plan_path);
+        } else {
+            fmt::print("Job `{}`: {} deleted, {} failed.\n", jobs[i].name, job.deleted, job.failed);
+        }
+    }
+
+    if (stats.interrupted) {
+        fmt::print(fg(fmt::color::yellow), "Interrupted. Continue the jobs that have a `journal` with `\"resume\": true`.\n");
+        return 130;
+    }
+    if (is_failed) return 1;
+    fmt::print(fg(fmt::color::light_green), "All jobs are done.\n");
+    return 0;
+}
+
 int main(const int argc, char** argv) {
     try {
         fmt::print("discord-rm\n");
@@ -52,6 +136,13 @@ int main(const int argc, char** argv) {
         auto& args = create_arguments();
         process_arguments(args, argc, argv);
 
+        if (!ARCHIVE_FIND.empty()) {
+            const auto record = find_archived(ARCHIVE_PATH, std::stoull(ARCHIVE_FIND));
+            if (!record) throw std::invalid_argument("Message " + ARCHIVE_FIND + " is not in `" + ARCHIVE_PATH + "`.");
+            fmt::print("{}\n", *record);
+            return 0;
+        }
+
         /*
          * Ask for the Discord token, even if not in an interactive session.
          * (Passing the Discord token as an argument is dangerous.)
@@ -65,10 +156,16 @@ int main(const int argc, char** argv) {
 
         if (IS_INTERACTIVE)
             InteractiveSession();
+        set_log_level(cli_log_level()); // Of what is logged outside the run, e.g. while the jobs are read
+
+        const std::vector<JobConfig> jobs = JOBS_PATH.empty() ? std::vector{job_from_options()} : read_job_manifest(JOBS_PATH, job_from_options());
+        const bool is_deleting = std::ranges::any_of(jobs, [](const JobConfig& job) { return job.plan_path.empty(); }); // A plan deletes nothing
+        if (!ARCHIVE_PATH.empty() && std::ranges::any_of(jobs, [](const JobConfig& job) { return !job.execute_plan_path.empty(); }))
+            throw std::invalid_argument("A plan only has message IDs, so `--execute-plan` cannot be used with `--archive`.");
 
         fmt::print(fg(fmt::color::yellow), "\nWARNING: Using self-bots may result in account termination.\n\n");
 
-        if (!IS_NOCONFIRM) {
+        if (!IS_NOCONFIRM && is_deleting) {
             std::string in;
             ask("Do you want to continue? [y/n]: ", in);
 
@@ -78,10 +175,45 @@ int main(const int argc, char** argv) {
             }
         }
 
-        discord_rm();
+        // Ctrl-C finishes the request in flight and flushes the journal. A second one exits immediately.
+        for (const int sig : {SIGINT, SIGTERM}) {
+            std::signal(sig, [](const int s) {
+                std::signal(s, SIG_DFL);
+                if (Remover* remover = RUNNING_REMOVER.load()) remover->cancel();
+            });
+        }
+
+#ifdef SIGUSR1
+        // `kill -USR1` writes the metrics report of the running deletion (`--metrics`)
+        std::signal(SIGUSR1, [](int) { request_metrics_report(); });
+#endif
+
+        Remover remover(remover_from_options(jobs));
+        RUNNING_REMOVER = &remover;
+        const RunStats stats = remover.run();
+        RUNNING_REMOVER = nullptr;
+
+        set_status({}); // The outcome follows the log
+        flush_log();
+        print_plans(jobs, stats);
+        if (!JOBS_PATH.empty()) return report_jobs(jobs, stats);
+
+        if (!stats.jobs[0].error.empty()) throw std::runtime_error(stats.jobs[0].error);
+        if (stats.interrupted) {
+            fmt::print(fg(fmt::color::yellow), "Interrupted.{}\n",
+                       JOURNAL_PATH.empty() ? "" : " Continue with `--journal " + JOURNAL_PATH + " --resume`.");
+            return 130;
+        }
+        if (!PLAN_PATH.empty()) {
+            fmt::print(fg(fmt::color::light_green), "Plan written to `{}`, run it with `--execute-plan {}`.\n", PLAN_PATH, PLAN_PATH);
+            return 0;
+        }
         fmt::print(fg(fmt::color::light_green), "All messages have been removed.\n");
         return 0;
     } catch (const std::exception& ex) {
+        RUNNING_REMOVER = nullptr;
+        set_status({});
+        flush_log();
         fmt::print(fg(fmt::color::red),"ERROR: {}\n", ex.what());
         return 1;
     }
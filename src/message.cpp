@@ -0,0 +1,214 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/message.hpp>
+#include <include/filter.hpp>
+#include <include/helpers.hpp>
+#include <nlohmann/json.hpp>
+#include <cstdint>
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using nlohmann::json;
+
+namespace {
+    /*
+     * Walks the body like a `const char*`, and keeps the position of the parser in `position`,
+     * so the handler can cut the JSON of a result out of the body.
+     */
+    struct TrackedIterator {
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = char;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const char*;
+        using reference = const char&;
+
+        const char* at = nullptr;
+        const char** position = nullptr;
+
+        reference operator*() const { return *at; }
+        TrackedIterator& operator++() {
+            *position = ++at;
+            return *this;
+        }
+        TrackedIterator operator++(int) {
+            TrackedIterator before = *this;
+            ++*this;
+            return before;
+        }
+        bool operator==(const TrackedIterator& other) const { return at == other.at; }
+    };
+
+    /*
+     * SAX handler for the search response:
+     *
+     *   { "total_results": N, "messages": [ [ {message}, ... ], ... ] }
+     *     depth 1                          2 3 4
+     *
+     * Inside a message, `attachments`, `embeds`, `sticker_items` and `message_snapshots`
+     * are arrays (depth 5) of objects (depth 6).
+     */
+    class SearchPageHandler {
+    public:
+        // With `position`, the JSON of every result is kept in `Message::raw`, see `TrackedIterator`
+        SearchPageHandler(SearchPage& page, const bool keep_content, const char* const* position)
+            : page(page), keep_content(keep_content), position(position) {}
+
+        bool null() { return true; }
+        bool boolean(bool) { return true; }
+        bool number_integer(const json::number_integer_t value) { return number(static_cast<int64_t>(value)); }
+        bool number_unsigned(const json::number_unsigned_t value) { return number(static_cast<int64_t>(value)); }
+        bool number_float(json::number_float_t, const json::string_t&) { return true; }
+        bool binary(json::binary_t&) { return true; }
+
+        bool string(json::string_t& value) {
+            if (depth == MESSAGE_DEPTH && in_message) {
+                switch (message_key) {
+                    case Key::ID: current().id = to_snowflake(value); break;
+                    case Key::CONTENT: if (keep_content) current().content = std::move(value); break;
+                    case Key::CHANNEL_ID: current().channel_id = to_snowflake(value); break;
+                    default: break;
+                }
+            } else if (depth == ITEM_DEPTH && in_message && item_key == Key::TYPE) {
+                item_type = value; // Reuses the buffer, classified once the item ends
+            }
+            return true;
+        }
+
+        bool key(json::string_t& name) {
+            if (depth == ROOT_DEPTH) root_key = to_key(name);
+            else if (depth == MESSAGE_DEPTH) message_key = to_key(name);
+            else if (depth == ITEM_DEPTH) item_key = (message_key == Key::ATTACHMENTS ? name == "content_type" : name == "type")
+                                                    ? Key::TYPE : Key::OTHER;
+            return true;
+        }
+
+        bool start_object(std::size_t) {
+            if (depth == GROUP_DEPTH && in_messages && group_index++ == 0) { // Only the first element of a group is the hit
+                page.messages.emplace_back();
+                in_message = true;
+                if (position) raw_begin = *position - 1; // The parser is just past the `{`
+            } else if (depth == MESSAGE_DEPTH && in_message && message_key == Key::POLL) {
+                current().features |= FEATURE_POLL;
+            } else if (depth == LIST_DEPTH && in_message) {
+                switch (message_key) {
+                    case Key::STICKERS: current().features |= FEATURE_STICKER; break;
+                    case Key::SNAPSHOTS: current().features |= FEATURE_FORWARD; break;
+                    default: break;
+                }
+                item_type.clear();
+            }
+            ++depth;
+            return true;
+        }
+
+        bool end_object() {
+            --depth;
+            if (depth == LIST_DEPTH && in_message) {
+                // Every attachment and embed counts, not only the first one
+                if (message_key == Key::ATTACHMENTS) current().features |= classify_attachment(item_type);
+                else if (message_key == Key::EMBEDS) current().features |= classify_embed(item_type);
+            } else if (depth == GROUP_DEPTH && in_message) {
+                in_message = false;
+                if (current().id == 0) { // We want to parse only user messages
+                    page.messages.pop_back();
+                    return true;
+                }
+                if (is_system_message(current().type)) current().features |= FEATURE_SYSTEM;
+                if (position) { // The parser is just past the `}`
+                    current().raw.assign(raw_begin, *position);
+                    std::ranges::replace_if(current().raw, [](const char c) { return c == '\n' || c == '\r'; }, ' '); // One record per line
+                }
+            }
+            return true;
+        }
+
+        bool start_array(std::size_t) {
+            if (depth == ROOT_DEPTH && root_key == Key::MESSAGES) in_messages = true;
+            else if (depth == MESSAGES_DEPTH && in_messages) group_index = 0;
+            ++depth;
+            return true;
+        }
+
+        bool end_array() {
+            --depth;
+            if (depth == ROOT_DEPTH) in_messages = false;
+            return true;
+        }
+
+        bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) {
+            throw std::runtime_error(std::string("Failed to parse search response: ") + ex.what());
+        }
+
+    private:
+        enum class Key { OTHER, TOTAL_RESULTS, MESSAGES, ID, TYPE, CONTENT, CHANNEL_ID, ATTACHMENTS, EMBEDS, POLL, STICKERS, SNAPSHOTS };
+
+        static constexpr int ROOT_DEPTH = 1, MESSAGES_DEPTH = 2, GROUP_DEPTH = 3, MESSAGE_DEPTH = 4, LIST_DEPTH = 5, ITEM_DEPTH = 6;
+
+        static Key to_key(const std::string_view name) {
+            if (name == "id") return Key::ID;
+            if (name == "type") return Key::TYPE;
+            if (name == "content") return Key::CONTENT;
+            if (name == "channel_id") return Key::CHANNEL_ID;
+            if (name == "attachments") return Key::ATTACHMENTS;
+            if (name == "embeds") return Key::EMBEDS;
+            if (name == "poll") return Key::POLL;
+            if (name == "sticker_items") return Key::STICKERS;
+            if (name == "message_snapshots") return Key::SNAPSHOTS;
+            if (name == "total_results") return Key::TOTAL_RESULTS;
+            if (name == "messages") return Key::MESSAGES;
+            return Key::OTHER;
+        }
+
+        bool number(const int64_t value) {
+            if (depth == ROOT_DEPTH && root_key == Key::TOTAL_RESULTS)
+                page.total_results = static_cast<unsigned int>(value);
+            else if (depth == MESSAGE_DEPTH && in_message && message_key == Key::TYPE)
+                current().type = static_cast<uint8_t>(value);
+            return true;
+        }
+
+        static uint64_t to_snowflake(const std::string_view s) {
+            uint64_t id = 0;
+            std::from_chars(s.data(), s.data() + s.size(), id);
+            return id;
+        }
+
+        Message& current() { return page.messages.back(); }
+
+        SearchPage& page;
+        bool keep_content;
+        int depth = 0;
+        bool in_messages = false, in_message = false;
+        unsigned int group_index = 0;
+        Key root_key = Key::OTHER, message_key = Key::OTHER, item_key = Key::OTHER;
+        std::string item_type; // `content_type` of the current attachment or `type` of the current embed
+        const char* const* position;
+        const char* raw_begin = nullptr; // Of the current result
+    };
+}
+
+void parse_search_page(const std::string_view body, SearchPage& page, const bool keep_content, const bool keep_raw) {
+    page.total_results = 0;
+    page.messages.clear();
+
+    if (!keep_raw) {
+        SearchPageHandler handler(page, keep_content, nullptr);
+        json::sax_parse(body.begin(), body.end(), &handler);
+        return;
+    }
+
+    const char* position = body.data();
+    SearchPageHandler handler(page, keep_content, &position);
+    json::sax_parse(TrackedIterator{body.data(), &position}, TrackedIterator{body.data() + body.size(), &position}, &handler);
+}
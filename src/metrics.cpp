@@ -0,0 +1,297 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/metrics.hpp>
+#include <include/client.hpp>
+#include <include/helpers.hpp>
+#include <include/logger.hpp>
+#include <include/config.hpp>
+#include <nlohmann/json.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <filesystem>
+#include <initializer_list>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+    constexpr const char* ENDPOINT_NAMES[ENDPOINT_COUNT] = {"search", "delete", "bulk_delete"};
+    constexpr const char* WAIT_CAUSE_NAMES[WAIT_CAUSE_COUNT] = {"bucket", "global", "fixed_delay", "index", "backoff"};
+    constexpr auto REPORT_POLL_INTERVAL = std::chrono::milliseconds(100); // How soon a requested report is written
+    constexpr long RATE_LIMITED_HTTP_CODE = 429;
+    constexpr long ACCEPTED_HTTP_CODE = 202; // The search index is not ready yet
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The report request is counted from a signal handler");
+    std::atomic<uint64_t> REPORT_REQUESTS = 0; // Every reporter writes a report when it changes
+
+    void write_file(const std::string& path, const std::string& contents) {
+        const std::string temporary = path + ".tmp";
+        {
+            std::ofstream out(temporary, std::ios::trunc);
+            out << contents;
+            if (!out.flush()) throw std::runtime_error("Failed to write metrics to `" + temporary + "`.");
+        }
+        std::filesystem::rename(temporary, path);
+    }
+}
+
+void LatencyHistogram::observe(const std::chrono::microseconds latency) {
+    const auto ms = latency.count() / 1000;
+    const auto bound = std::ranges::lower_bound(BOUNDS_MS, ms, {}, [](const uint32_t b) { return static_cast<int64_t>(b); });
+    buckets[static_cast<size_t>(bound - BOUNDS_MS.begin())].fetch_add(1, std::memory_order_relaxed);
+    sum_us.fetch_add(latency.count(), std::memory_order_relaxed);
+}
+
+void LatencyHistogram::reset() {
+    for (auto& b : buckets) b.store(0, std::memory_order_relaxed);
+    sum_us.store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::count() const {
+    uint64_t total = 0;
+    for (const auto& b : buckets) total += b.load(std::memory_order_relaxed);
+    return total;
+}
+
+void Metrics::reset() {
+    for (auto& endpoint : endpoints) {
+        for (auto& s : endpoint.status) s.store(0, std::memory_order_relaxed);
+        endpoint.bytes.store(0, std::memory_order_relaxed);
+        endpoint.latency.reset();
+    }
+    for (auto& w : waited_ns) w.store(0, std::memory_order_relaxed);
+    deleted_count.store(0, std::memory_order_relaxed);
+    failed_count.store(0, std::memory_order_relaxed);
+    stale_count.store(0, std::memory_order_relaxed);
+    for (auto* count : {&expected_count, &found_count, &queued_count, &skipped_count, &planned_count}) count->store(0, std::memory_order_relaxed);
+    blocked_ns.store(0, std::memory_order_relaxed);
+    started.store(std::chrono::steady_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+}
+
+void Metrics::request(const Endpoint endpoint, const Response& response) {
+    EndpointMetrics& e = endpoints[static_cast<size_t>(endpoint)];
+    const long status = response.result == CURLE_OK && response.http_code > 0 && response.http_code < MAX_STATUS ? response.http_code : 0;
+
+    e.status[static_cast<size_t>(status)].fetch_add(1, std::memory_order_relaxed);
+    e.bytes.fetch_add(response.bytes, std::memory_order_relaxed);
+    e.latency.observe(response.elapsed);
+}
+
+void Metrics::waited(const WaitCause cause, const std::chrono::nanoseconds duration) {
+    if (duration.count() > 0) waited_ns[static_cast<size_t>(cause)].fetch_add(duration.count(), std::memory_order_relaxed);
+}
+
+RunCounts Metrics::counts() const {
+    RunCounts c;
+    c.expected = expected_count.load(std::memory_order_relaxed);
+    c.found = found_count.load(std::memory_order_relaxed);
+    c.queued = queued_count.load(std::memory_order_relaxed);
+    c.deleted = deleted_count.load(std::memory_order_relaxed);
+    c.failed = failed_count.load(std::memory_order_relaxed);
+    c.planned = planned_count.load(std::memory_order_relaxed);
+    c.skipped = skipped_count.load(std::memory_order_relaxed);
+    c.stale = stale_count.load(std::memory_order_relaxed);
+    c.blocked = std::chrono::nanoseconds(blocked_ns.load(std::memory_order_relaxed));
+    c.elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed());
+    return c;
+}
+
+uint64_t Metrics::requests() const {
+    uint64_t total = 0;
+    for (const auto& endpoint : endpoints)
+        for (const auto& s : endpoint.status) total += s.load(std::memory_order_relaxed);
+    return total;
+}
+
+uint64_t Metrics::rate_limited() const {
+    uint64_t total = 0;
+    for (const auto& endpoint : endpoints) total += endpoint.status[RATE_LIMITED_HTTP_CODE].load(std::memory_order_relaxed);
+    return total;
+}
+
+uint64_t Metrics::index_waits() const {
+    uint64_t total = 0;
+    for (const auto& endpoint : endpoints) total += endpoint.status[ACCEPTED_HTTP_CODE].load(std::memory_order_relaxed);
+    return total;
+}
+
+std::chrono::nanoseconds Metrics::waited() const {
+    int64_t total = 0;
+    for (const auto& w : waited_ns) total += w.load(std::memory_order_relaxed);
+    return std::chrono::nanoseconds(total);
+}
+
+std::chrono::duration<double> Metrics::elapsed() const {
+    const std::chrono::steady_clock::time_point start{std::chrono::steady_clock::duration(started.load(std::memory_order_relaxed))};
+    return std::chrono::steady_clock::now() - start;
+}
+
+std::string Metrics::to_json() const {
+    const double seconds = elapsed().count();
+    const uint64_t deleted = deleted_count.load(std::memory_order_relaxed);
+    nlohmann::ordered_json report;
+
+    report["elapsed_seconds"] = seconds;
+    report["messages"] = {{"deleted", deleted},
+                          {"failed", failed_count.load(std::memory_order_relaxed)},
+                          {"skipped", skipped_count.load(std::memory_order_relaxed)},
+                          {"stale", stale_count.load(std::memory_order_relaxed)},
+                          {"deleted_per_second", seconds > 0 ? static_cast<double>(deleted) / seconds : 0.0}};
+
+    auto& waits = report["wait_seconds"] = nlohmann::ordered_json::object();
+    for (size_t c = 0; c < WAIT_CAUSE_COUNT; ++c)
+        waits[WAIT_CAUSE_NAMES[c]] = std::chrono::duration<double>(std::chrono::nanoseconds(waited_ns[c].load(std::memory_order_relaxed))).count();
+
+    auto& by_endpoint = report["endpoints"] = nlohmann::ordered_json::object();
+    for (size_t i = 0; i < ENDPOINT_COUNT; ++i) {
+        const EndpointMetrics& e = endpoints[i];
+        nlohmann::ordered_json statuses = nlohmann::ordered_json::object(), buckets = nlohmann::ordered_json::object();
+        uint64_t requests = 0;
+
+        for (size_t s = 0; s < e.status.size(); ++s) {
+            if (const uint64_t n = e.status[s].load(std::memory_order_relaxed)) {
+                statuses[std::to_string(s)] = n;
+                requests += n;
+            }
+        }
+        for (size_t b = 0; b <= LatencyHistogram::BOUNDS_MS.size(); ++b)
+            buckets[b < LatencyHistogram::BOUNDS_MS.size() ? std::to_string(LatencyHistogram::BOUNDS_MS[b]) : "+Inf"] = e.latency.bucket(b);
+
+        by_endpoint[ENDPOINT_NAMES[i]] = {
+            {"requests", requests},
+            {"status", std::move(statuses)},
+            {"rate_limited", e.status[RATE_LIMITED_HTTP_CODE].load(std::memory_order_relaxed)},
+            {"index_waits", e.status[ACCEPTED_HTTP_CODE].load(std::memory_order_relaxed)},
+            {"bytes", e.bytes.load(std::memory_order_relaxed)},
+            {"latency_ms", {{"count", e.latency.count()},
+                            {"sum", std::chrono::duration<double, std::milli>(e.latency.sum()).count()},
+                            {"buckets", std::move(buckets)}}}
+        };
+    }
+    return report.dump(2) + '\n';
+}
+
+std::string Metrics::to_prometheus() const {
+    const double seconds = elapsed().count();
+    const uint64_t deleted = deleted_count.load(std::memory_order_relaxed);
+    std::string out;
+
+    out += "# HELP discord_rm_requests_total Requests by endpoint and HTTP status, 0 for transport errors.\n";
+    out += "# TYPE discord_rm_requests_total counter\n";
+    for (size_t i = 0; i < ENDPOINT_COUNT; ++i)
+        for (size_t s = 0; s < endpoints[i].status.size(); ++s)
+            if (const uint64_t n = endpoints[i].status[s].load(std::memory_order_relaxed))
+                out += fmt::format("discord_rm_requests_total{{endpoint=\"{}\",status=\"{}\"}} {}\n", ENDPOINT_NAMES[i], s, n);
+
+    out += "# HELP discord_rm_rate_limited_total Requests answered with 429.\n";
+    out += "# TYPE discord_rm_rate_limited_total counter\n";
+    for (size_t i = 0; i < ENDPOINT_COUNT; ++i)
+        out += fmt::format("discord_rm_rate_limited_total{{endpoint=\"{}\"}} {}\n", ENDPOINT_NAMES[i],
+                           endpoints[i].status[RATE_LIMITED_HTTP_CODE].load(std::memory_order_relaxed));
+
+    out += "# HELP discord_rm_index_waits_total Requests answered with 202 because the search index was not ready.\n";
+    out += "# TYPE discord_rm_index_waits_total counter\n";
+    for (size_t i = 0; i < ENDPOINT_COUNT; ++i)
+        out += fmt::format("discord_rm_index_waits_total{{endpoint=\"{}\"}} {}\n", ENDPOINT_NAMES[i],
+                           endpoints[i].status[ACCEPTED_HTTP_CODE].load(std::memory_order_relaxed));
+
+    out += "# HELP discord_rm_request_duration_seconds Request latency, to the last byte of the response.\n";
+    out += "# TYPE discord_rm_request_duration_seconds histogram\n";
+    for (size_t i = 0; i < ENDPOINT_COUNT; ++i) {
+        const LatencyHistogram& latency = endpoints[i].latency;
+        uint64_t cumulative = 0;
+        for (size_t b = 0; b <= LatencyHistogram::BOUNDS_MS.size(); ++b) {
+            cumulative += latency.bucket(b);
+            const std::string le = b < LatencyHistogram::BOUNDS_MS.size() ? fmt::format("{}", LatencyHistogram::BOUNDS_MS[b] / 1000.0) : "+Inf";
+            out += fmt::format("discord_rm_request_duration_seconds_bucket{{endpoint=\"{}\",le=\"{}\"}} {}\n", ENDPOINT_NAMES[i], le, cumulative);
+        }
+        out += fmt::format("discord_rm_request_duration_seconds_sum{{endpoint=\"{}\"}} {}\n", ENDPOINT_NAMES[i],
+                           std::chrono::duration<double>(latency.sum()).count());
+        out += fmt::format("discord_rm_request_duration_seconds_count{{endpoint=\"{}\"}} {}\n", ENDPOINT_NAMES[i], cumulative);
+    }
+
+    out += "# HELP discord_rm_transferred_bytes_total Bytes sent and received, headers included.\n";
+    out += "# TYPE discord_rm_transferred_bytes_total counter\n";
+    for (size_t i = 0; i < ENDPOINT_COUNT; ++i)
+        out += fmt::format("discord_rm_transferred_bytes_total{{endpoint=\"{}\"}} {}\n", ENDPOINT_NAMES[i],
+                           endpoints[i].bytes.load(std::memory_order_relaxed));
+
+    out += "# HELP discord_rm_wait_seconds_total Time spent waiting instead of sending, by cause.\n";
+    out += "# TYPE discord_rm_wait_seconds_total counter\n";
+    for (size_t c = 0; c < WAIT_CAUSE_COUNT; ++c)
+        out += fmt::format("discord_rm_wait_seconds_total{{cause=\"{}\"}} {}\n", WAIT_CAUSE_NAMES[c],
+                           std::chrono::duration<double>(std::chrono::nanoseconds(waited_ns[c].load(std::memory_order_relaxed))).count());
+
+    out += "# HELP discord_rm_messages_deleted_total Messages deleted.\n";
+    out += "# TYPE discord_rm_messages_deleted_total counter\n";
+    out += fmt::format("discord_rm_messages_deleted_total {}\n", deleted);
+    out += "# HELP discord_rm_messages_failed_total Messages that could not be deleted.\n";
+    out += "# TYPE discord_rm_messages_failed_total counter\n";
+    out += fmt::format("discord_rm_messages_failed_total {}\n", failed_count.load(std::memory_order_relaxed));
+    out += "# HELP discord_rm_messages_skipped_total Excluded by the filters.\n";
+    out += "# TYPE discord_rm_messages_skipped_total counter\n";
+    out += fmt::format("discord_rm_messages_skipped_total {}\n", skipped_count.load(std::memory_order_relaxed));
+    out += "# HELP discord_rm_messages_stale_total Found again after their deletion and left out.\n";
+    out += "# TYPE discord_rm_messages_stale_total counter\n";
+    out += fmt::format("discord_rm_messages_stale_total {}\n", stale_count.load(std::memory_order_relaxed));
+    out += "# HELP discord_rm_deleted_per_second Messages deleted per second of the run.\n";
+    out += "# TYPE discord_rm_deleted_per_second gauge\n";
+    out += fmt::format("discord_rm_deleted_per_second {}\n", seconds > 0 ? static_cast<double>(deleted) / seconds : 0.0);
+    out += "# HELP discord_rm_elapsed_seconds Time since the run started.\n";
+    out += "# TYPE discord_rm_elapsed_seconds gauge\n";
+    out += fmt::format("discord_rm_elapsed_seconds {}\n", seconds);
+    return out;
+}
+
+void Metrics::write(const std::string& prefix) const {
+    write_file(prefix + ".json", to_json());
+    write_file(prefix + ".prom", to_prometheus());
+}
+
+void request_metrics_report() {
+    REPORT_REQUESTS.fetch_add(1, std::memory_order_relaxed);
+}
+
+MetricsReporter::MetricsReporter(const Metrics& metrics, std::string prefix)
+    : metrics(metrics), prefix(std::move(prefix)), reported(REPORT_REQUESTS.load(std::memory_order_relaxed)) {
+    thread = std::thread([this, level = log_level()] {
+        const LogLevelScope log_scope(level);
+        std::unique_lock lock(mutex);
+        while (!stopped.wait_for(lock, REPORT_POLL_INTERVAL, [this] { return is_stopping; })) {
+            const uint64_t requests = REPORT_REQUESTS.load(std::memory_order_relaxed);
+            if (requests == reported) continue;
+            reported = requests;
+            try {
+                this->metrics.write(this->prefix);
+                verbose("Metrics: Report written to `{0}.json` and `{0}.prom`.", this->prefix);
+            } catch (const std::exception& e) {
+                verbose(WARNING, "Metrics: {}", e.what());
+            }
+        }
+    });
+}
+
+MetricsReporter::~MetricsReporter() {
+    {
+        std::scoped_lock lock(mutex);
+        is_stopping = true;
+    }
+    stopped.notify_one();
+    thread.join();
+
+    try {
+        metrics.write(prefix);
+    } catch (const std::exception& e) {
+        info(WARNING, "Metrics: {}", e.what());
+    }
+}
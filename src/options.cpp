@@ -0,0 +1,58 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/options.hpp>
+#include <include/job.hpp>
+#include <include/filter.hpp>
+#include <include/plan.hpp>
+#include <include/config.hpp>
+#include <utility>
+
+FeatureSet compile_filter() {
+    // To add a filter kind, add a feature, classify it while parsing and map its option here
+    const std::pair<bool, Feature> options[] = {
+        {NO_POLL,    FEATURE_POLL},
+        {NO_EMBED,   FEATURE_EMBED},
+        {NO_LINK,    FEATURE_LINK},
+        {NO_FILE,    FEATURE_FILE},
+        {NO_IMAGE,   FEATURE_IMAGE},
+        {NO_VIDEO,   FEATURE_VIDEO},
+        {NO_SOUND,   FEATURE_AUDIO},
+        {NO_STICKER, FEATURE_STICKER},
+        {NO_FORWARD, FEATURE_FORWARD}
+    };
+
+    FeatureSet rules = FEATURE_SYSTEM;
+    for (const auto& [enabled, feature] : options)
+        if (enabled) rules |= feature;
+    return rules;
+}
+
+JobConfig job_from_options() {
+    JobConfig job;
+    job.guild_id          = GUILD_ID;
+    job.channel_id        = CHANNEL_ID;
+    job.sender_id         = SENDER_ID;
+    job.mentions          = MENTIONS;
+    job.before_date       = BEFORE_DATE;
+    job.during_date       = DURING_DATE;
+    job.after_date        = AFTER_DATE;
+    job.rules             = compile_filter();
+    job.remove_pinned     = REMOVE_PINNED;
+    job.bulk_delete       = IS_BULK_DELETE;
+    job.skip_if_fail      = IS_SKIP_IF_FAIL;
+    job.journal_path      = JOURNAL_PATH;
+    job.resume            = IS_RESUME;
+    job.import_path       = IMPORT_PATH;
+    job.plan_path         = PLAN_PATH;
+    job.execute_plan_path = EXECUTE_PLAN_PATH;
+
+    if (!job.execute_plan_path.empty()) apply_plan_header(job.execute_plan_path, job);
+    job.name = default_job_name(job);
+    return job;
+}
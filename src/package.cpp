@@ -0,0 +1,269 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/package.hpp>
+#include <include/message.hpp>
+#include <include/filter.hpp>
+#include <include/helpers.hpp>
+#include <include/logger.hpp>
+#include <include/job.hpp>
+#include <include/mapped_file.hpp>
+#include <nlohmann/json.hpp>
+#include <algorithm>
+#include <charconv>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+    uint64_t to_snowflake(const std::string_view s) {
+        uint64_t id = 0;
+        std::from_chars(s.data(), s.data() + s.size(), id);
+        return id;
+    }
+
+    // Date range, mentions and features of one exported message, as the search would apply them.
+    class MessageScope {
+    public:
+        MessageScope(const JobConfig& job, const bool keep_content) : range(search_range(job)), keep_content(keep_content) {
+            for (const auto& id : job.mentions) {
+                mentions.push_back("<@" + id + ">");
+                mentions.push_back("<@!" + id + ">");
+            }
+        }
+
+        // Fills in `message` and returns true if it is in scope.
+        bool accept(Message& message, std::string& contents, const std::string_view attachments) const {
+            if (message.id <= range.min_id || message.id >= range.max_id) return false;
+
+            if (!mentions.empty()) {
+                bool mentioned = false;
+                for (const auto& mention : mentions) mentioned = mentioned || contents.find(mention) != std::string::npos;
+                if (!mentioned) return false;
+            }
+
+            message.features = 0;
+            for (size_t start = 0; start < attachments.size();) { // Space separated URLs
+                const size_t end = std::min(attachments.find(' ', start), attachments.size());
+                if (end > start) message.features |= classify_attachment_url(attachments.substr(start, end - start));
+                start = end + 1;
+            }
+            // Discord unfurls links in the content into link embeds
+            if (contents.find("http://") != std::string::npos || contents.find("https://") != std::string::npos)
+                message.features |= classify_embed("link");
+
+            if (keep_content) message.content = std::move(contents);
+            return true;
+        }
+
+    private:
+        SnowflakeRange range;
+        std::vector<std::string> mentions;
+        bool keep_content;
+    };
+
+    // SAX handler for `messages.json`: an array of flat message objects.
+    class MessagesHandler {
+    public:
+        MessagesHandler(const uint64_t channel_id, const MessageScope& scope, const std::function<bool(Message&)>& on_message)
+            : channel_id(channel_id), scope(scope), on_message(on_message) {}
+
+        bool null() { return true; }
+        bool boolean(bool) { return true; }
+        bool number_integer(const json::number_integer_t value) { return number(static_cast<uint64_t>(value)); }
+        bool number_unsigned(const json::number_unsigned_t value) { return number(value); }
+        bool number_float(json::number_float_t, const json::string_t&) { return true; }
+        bool binary(json::binary_t&) { return true; }
+
+        bool string(json::string_t& value) {
+            if (depth != MESSAGE_DEPTH) return true;
+            switch (field) {
+                case Key::ID: message.id = to_snowflake(value); break;
+                case Key::CONTENTS: contents = std::move(value); break;
+                case Key::ATTACHMENTS: attachments = std::move(value); break;
+                default: break;
+            }
+            return true;
+        }
+
+        bool key(json::string_t& name) {
+            if (depth == MESSAGE_DEPTH)
+                field = name == "ID" ? Key::ID : name == "Contents" ? Key::CONTENTS : name == "Attachments" ? Key::ATTACHMENTS : Key::OTHER;
+            return true;
+        }
+
+        bool start_object(std::size_t) {
+            if (depth == ARRAY_DEPTH) {
+                message = Message();
+                message.channel_id = channel_id;
+                contents.clear();
+                attachments.clear();
+            }
+            ++depth;
+            return true;
+        }
+
+        bool end_object() {
+            --depth;
+            if (depth == ARRAY_DEPTH && message.id != 0 && scope.accept(message, contents, attachments))
+                return on_message(message); // false stops the parser
+            return true;
+        }
+
+        bool start_array(std::size_t) { ++depth; return true; }
+        bool end_array() { --depth; return true; }
+
+        bool parse_error(std::size_t, const std::string&, const nlohmann::detail::exception& ex) {
+            throw std::runtime_error(std::string("Failed to parse data package: ") + ex.what());
+        }
+
+    private:
+        enum class Key { OTHER, ID, CONTENTS, ATTACHMENTS };
+
+        static constexpr int ARRAY_DEPTH = 1, MESSAGE_DEPTH = 2;
+
+        bool number(const uint64_t value) {
+            if (depth == MESSAGE_DEPTH && field == Key::ID) message.id = value; // Newer packages store the ID as a number
+            return true;
+        }
+
+        uint64_t channel_id;
+        const MessageScope& scope;
+        const std::function<bool(Message&)>& on_message;
+        int depth = 0;
+        Key field = Key::OTHER;
+        Message message;
+        std::string contents, attachments;
+    };
+
+    /*
+     * Reads the next CSV record starting at `pos` into `fields`.
+     * Quoted fields may contain commas and line breaks, and escape quotes by doubling them.
+     */
+    bool next_record(const std::string_view data, size_t& pos, std::vector<std::string>& fields) {
+        if (pos >= data.size()) return false;
+
+        fields.clear();
+        fields.emplace_back();
+        bool quoted = false;
+
+        for (; pos < data.size(); ++pos) {
+            const char c = data[pos];
+            if (quoted) {
+                if (c != '"') fields.back() += c;
+                else if (pos + 1 < data.size() && data[pos + 1] == '"') fields.back() += data[++pos];
+                else quoted = false;
+            } else if (c == '"') {
+                quoted = true;
+            } else if (c == ',') {
+                fields.emplace_back();
+            } else if (c == '\n') {
+                ++pos;
+                break;
+            } else if (c != '\r') {
+                fields.back() += c;
+            }
+        }
+        return true;
+    }
+
+    bool read_messages_csv(const std::string_view data, const uint64_t channel_id, const MessageScope& scope,
+                           const std::function<bool(Message&)>& on_message) {
+        std::vector<std::string> fields;
+        size_t pos = 0;
+        if (!next_record(data, pos, fields)) return true;
+
+        // Columns are looked up by name in the header
+        size_t id_column = fields.size(), contents_column = fields.size(), attachments_column = fields.size();
+        for (size_t i = 0; i < fields.size(); ++i) {
+            if (fields[i] == "ID") id_column = i;
+            else if (fields[i] == "Contents") contents_column = i;
+            else if (fields[i] == "Attachments") attachments_column = i;
+        }
+        if (id_column == fields.size()) throw std::runtime_error("Failed to parse data package: `messages.csv` has no ID column.");
+
+        Message message;
+        std::string contents;
+        while (next_record(data, pos, fields)) {
+            if (fields.size() <= id_column) continue; // Blank line
+
+            message = Message();
+            message.id = to_snowflake(fields[id_column]);
+            message.channel_id = channel_id;
+            if (message.id == 0) continue;
+
+            contents = contents_column < fields.size() ? std::move(fields[contents_column]) : std::string();
+            const std::string_view attachments = attachments_column < fields.size() ? std::string_view(fields[attachments_column]) : std::string_view();
+
+            if (scope.accept(message, contents, attachments) && !on_message(message)) return false;
+        }
+        return true;
+    }
+
+    // Channel folders are named `c<id>` in current packages and `<id>` in older ones.
+    fs::path channel_folder(const fs::path& messages, const std::string& id) {
+        if (const auto current = messages / ("c" + id); fs::is_directory(current)) return current;
+        return messages / id;
+    }
+
+    bool in_guild(const fs::path& folder, const std::string& guild_id) {
+        std::ifstream in(folder / "channel.json");
+        const json channel = json::parse(in, nullptr, false);
+        if (channel.is_discarded() || !channel.is_object() || !channel.contains("guild")) return false; // DMs have no guild
+
+        const auto& guild = channel["guild"];
+        return guild.is_object() && guild.contains("id") && guild["id"].is_string() && guild["id"].get<std::string>() == guild_id;
+    }
+}
+
+void read_data_package(const std::string& root, const JobConfig& job, const bool keep_content, const std::function<bool(Message&)>& on_message) {
+    // Accept both the package root and its `messages` folder
+    fs::path messages = fs::path(root) / "messages";
+    if (!fs::exists(messages / "index.json")) messages = root;
+    if (!fs::exists(messages / "index.json"))
+        throw std::invalid_argument("`" + root + "` is not a Discord data package (no `messages/index.json`).");
+
+    std::vector<std::string> channels;
+    if (!job.channel_id.empty()) {
+        channels.push_back(job.channel_id);
+    } else {
+        const MappedFile index(messages / "index.json");
+        const json ids = json::parse(index.view());
+        if (!ids.is_object()) throw std::runtime_error("Failed to parse data package: `index.json` is not an object.");
+        for (const auto& [id, _] : ids.items()) channels.push_back(id);
+    }
+
+    const MessageScope scope(job, keep_content);
+    for (const auto& id : channels) {
+        const fs::path folder = channel_folder(messages, id);
+        if (!fs::is_directory(folder)) continue; // Listed in the index, but nothing was exported
+        if (job.channel_id.empty() && !in_guild(folder, job.guild_id)) continue;
+
+        debug("[Data Package] Reading channel {}", id);
+        const uint64_t channel_id = to_snowflake(id);
+
+        if (const auto path = folder / "messages.json"; fs::exists(path)) {
+            const MappedFile file(path);
+            const auto data = file.view();
+            MessagesHandler handler(channel_id, scope, on_message);
+            if (!data.empty() && !json::sax_parse(data.begin(), data.end(), &handler)) return;
+        } else if (const auto csv = folder / "messages.csv"; fs::exists(csv)) {
+            const MappedFile file(csv);
+            if (!read_messages_csv(file.view(), channel_id, scope, on_message)) return;
+        }
+    }
+}
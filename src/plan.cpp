@@ -0,0 +1,197 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/plan.hpp>
+#include <include/message.hpp>
+#include <include/filter.hpp>
+#include <include/scheduler.hpp>
+#include <include/mapped_file.hpp>
+#include <include/job.hpp>
+#include <include/helpers.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <charconv>
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+
+namespace {
+    constexpr unsigned int PLAN_BATCH_SIZE = 256; // Records per write
+
+    /*
+     * Discord does not publish the delete limits, these are what the API usually advertises for user accounts.
+     * Channels are deleted in parallel (see `ChannelScheduler`), all of them share the global limit.
+     */
+    constexpr double DELETES_PER_SECOND_PER_CHANNEL = 1.0;
+    constexpr double REQUESTS_PER_SECOND_GLOBAL = 50.0;
+
+    constexpr std::pair<Feature, const char*> FEATURE_NAMES[] = {
+        {FEATURE_POLL, "poll"}, {FEATURE_EMBED, "embed"}, {FEATURE_LINK, "link"}, {FEATURE_FILE, "file"},
+        {FEATURE_IMAGE, "image"}, {FEATURE_VIDEO, "video"}, {FEATURE_AUDIO, "audio"},
+        {FEATURE_STICKER, "sticker"}, {FEATURE_FORWARD, "forward"}
+    };
+
+    // Longest channel or the global limit, whichever takes longer.
+    double estimate_seconds(const std::map<uint64_t, uint64_t>& requests_per_channel, const std::chrono::milliseconds delay) {
+        const double per_request = std::max(1.0 / DELETES_PER_SECOND_PER_CHANNEL, std::chrono::duration<double>(delay).count());
+        uint64_t total = 0, longest = 0;
+        for (const auto& [_, requests] : requests_per_channel) {
+            total += requests;
+            longest = std::max(longest, requests);
+        }
+        return std::max(static_cast<double>(longest) * per_request, static_cast<double>(total) / REQUESTS_PER_SECOND_GLOBAL);
+    }
+
+    std::string format_duration(const double seconds) {
+        const auto s = static_cast<uint64_t>(seconds + 0.5);
+        if (s >= 3600) return fmt::format("{}h {:02}m {:02}s", s / 3600, s / 60 % 60, s % 60);
+        if (s >= 60) return fmt::format("{}m {:02}s", s / 60, s % 60);
+        return fmt::format("{}s", s);
+    }
+
+    template <typename T>
+    void append_number(std::string& out, const T value, const int base = 10) {
+        char digits[20];
+        const auto [end, _] = std::to_chars(digits, digits + sizeof(digits), value, base);
+        out.append(digits, end);
+    }
+
+    template <typename T>
+    bool parse_number(const std::string_view s, T& value, const int base = 10) {
+        const auto [end, ec] = std::from_chars(s.data(), s.data() + s.size(), value, base);
+        return ec == std::errc() && end == s.data() + s.size();
+    }
+}
+
+PlanWriter::PlanWriter(const std::string& path, const JobConfig& job, const std::chrono::milliseconds delay)
+    : oldest_bulk_ms(ChannelScheduler::bulk_cutoff_ms()), delay(delay), is_bulk(job.bulk_delete && !is_dm_guild(job.guild_id)) {
+    file.open(path, std::ios::trunc);
+    if (!file) throw std::runtime_error("Failed to open plan `" + path + "`.");
+
+    file << "# discord-rm deletion plan, run it with `--execute-plan`\n";
+    file << "H " << run_header(job) << '\n';
+}
+
+PlanWriter::~PlanWriter() {
+    write_pending();
+}
+
+void PlanWriter::add(const Message& message) {
+    pending += "M ";
+    append_number(pending, message.channel_id);
+    pending += ' ';
+    append_number(pending, message.id);
+    pending += ' ';
+    append_number(pending, message.features, 16);
+    pending += '\n';
+
+    ChannelCount& channel = channels[message.channel_id];
+    ++channel.messages;
+    if (ChannelScheduler::is_bulk_deletable(message, oldest_bulk_ms)) ++channel.bulk;
+
+    for (size_t bit = 0; bit < features.size(); ++bit)
+        if (message.features & (1u << bit)) ++features[bit];
+    if (message.features == 0) ++plain;
+
+    if (++total % PLAN_BATCH_SIZE == 0) write_pending();
+}
+
+std::string PlanWriter::finish() {
+    std::map<uint64_t, uint64_t> single_requests, bulk_requests;
+    std::string summary = fmt::format("Messages: {} in {} channels\n", total, channels.size());
+
+    for (const auto& [id, count] : channels) {
+        summary += fmt::format("Channel {}: {} ({} young enough for bulk delete)\n", id, count.messages, count.bulk);
+        single_requests[id] = count.messages;
+        bulk_requests[id] = count.messages - count.bulk + (count.bulk + ChannelScheduler::BULK_DELETE_LIMIT - 1) / ChannelScheduler::BULK_DELETE_LIMIT;
+    }
+
+    summary += fmt::format("Type text only: {}\n", plain);
+    for (const auto& [feature, name] : FEATURE_NAMES) {
+        const auto bit = static_cast<size_t>(std::countr_zero(static_cast<unsigned int>(feature)));
+        if (features[bit]) summary += fmt::format("Type {}: {}\n", name, features[bit]);
+    }
+
+    uint64_t bulk_total = 0;
+    for (const auto& [_, requests] : bulk_requests) bulk_total += requests;
+    summary += fmt::format("Estimated runtime: {} ({} requests)\n", format_duration(estimate_seconds(single_requests, delay)), total);
+    if (is_bulk)
+        summary += fmt::format("Estimated runtime with Manage Messages: {} ({} requests)\n",
+                               format_duration(estimate_seconds(bulk_requests, delay)), bulk_total);
+
+    write_pending();
+    file << "#\n";
+    for (size_t start = 0; start < summary.size();) {
+        const size_t end = summary.find('\n', start);
+        file << "# " << std::string_view(summary).substr(start, end - start) << '\n';
+        start = end + 1;
+    }
+    file.flush();
+    return summary;
+}
+
+void PlanWriter::write_pending() {
+    if (pending.empty()) return;
+
+    file.write(pending.data(), static_cast<std::streamsize>(pending.size()));
+    pending.clear();
+}
+
+void apply_plan_header(const std::string& path, JobConfig& job) {
+    std::ifstream in(path);
+    if (!in) throw std::invalid_argument("Plan `" + path + "` does not exist.");
+
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.starts_with("H ")) continue;
+
+        std::string ids[3];
+        size_t start = 2;
+        for (auto& id : ids) {
+            const size_t end = std::min(line.find(' ', start), line.size());
+            id = line.substr(start, end - start);
+            start = end + 1;
+        }
+
+        if (job.guild_id.empty()) job.guild_id = ids[0];
+        if (job.channel_id.empty() && job.guild_id == ids[0]) job.channel_id = ids[1];
+        if (job.sender_id.empty()) job.sender_id = ids[2];
+        return;
+    }
+    throw std::invalid_argument("`" + path + "` is not a deletion plan.");
+}
+
+void read_plan(const std::string& path, const std::function<bool(Message&)>& on_message) {
+    const MappedFile file(path);
+    const std::string_view data = file.view();
+    Message message;
+
+    for (size_t start = 0; start < data.size();) {
+        const size_t end = std::min(data.find('\n', start), data.size());
+        const std::string_view line = data.substr(start, end - start);
+        start = end + 1;
+        if (!line.starts_with("M ")) continue;
+
+        // M <channel id> <message id> <features>
+        const size_t first = line.find(' ', 2), second = line.find(' ', first + 1);
+        if (second == std::string_view::npos) continue; // Torn write
+
+        message = Message();
+        if (!parse_number(line.substr(2, first - 2), message.channel_id)
+            || !parse_number(line.substr(first + 1, second - first - 1), message.id)
+            || !parse_number(line.substr(second + 1), message.features, 16))
+            continue;
+
+        if (!on_message(message)) return;
+    }
+}
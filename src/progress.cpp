@@ -0,0 +1,112 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/progress.hpp>
+#include <include/metrics.hpp>
+#include <include/logger.hpp>
+#include <fmt/format.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <utility>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+    std::string format_duration(const double seconds) {
+        const auto s = static_cast<uint64_t>(std::llround(seconds));
+        if (s >= 3600) return fmt::format("{}h{:02}m", s / 3600, s / 60 % 60);
+        if (s >= 60) return fmt::format("{}m{:02}s", s / 60, s % 60);
+        return fmt::format("{}s", s);
+    }
+
+    double seconds(const std::chrono::nanoseconds duration) {
+        return std::chrono::duration<double>(duration).count();
+    }
+}
+
+bool is_terminal_output() {
+#ifdef _WIN32
+    return _isatty(_fileno(stdout));
+#else
+    return isatty(fileno(stdout));
+#endif
+}
+
+std::string format_progress(const Progress& progress) {
+    const auto& [counts, current, average, blocked] = progress;
+    std::string line = counts.planned ? fmt::format("{} planned", counts.planned) : fmt::format("{} deleted", counts.deleted);
+    line += fmt::format(", {} skipped", counts.skipped + counts.stale);
+    if (counts.failed) line += fmt::format(", {} failed", counts.failed);
+
+    // Results the search has announced but not returned yet, and what is queued
+    const uint64_t unsearched = counts.expected > counts.found ? counts.expected - counts.found : 0;
+    const uint64_t finished = counts.deleted + counts.failed + counts.planned;
+    const uint64_t left = unsearched + (counts.queued > finished ? counts.queued - finished : 0);
+    const bool is_known = counts.expected || counts.found;
+    if (is_known) line += fmt::format(", ~{} left", left);
+
+    line += fmt::format(" | {:.1f}/s (avg {:.1f}/s) | {:.0f}% rate limited", current, average, blocked * 100);
+    if (is_known && average > 0.01) line += " | ETA " + format_duration(static_cast<double>(left) / average);
+    return line;
+}
+
+ProgressReporter::ProgressReporter(const Metrics& metrics, const std::chrono::milliseconds interval,
+                                   std::function<void(const Progress&)> on_progress)
+    : metrics(metrics), on_progress(std::move(on_progress)) {
+    samples.push_back({});
+    thread = std::thread([this, interval, level = log_level()] {
+        const LogLevelScope log_scope(level);
+        std::unique_lock lock(mutex);
+        while (!stopped.wait_for(lock, interval, [this] { return is_stopping; })) update();
+    });
+}
+
+ProgressReporter::~ProgressReporter() {
+    {
+        std::scoped_lock lock(mutex);
+        is_stopping = true;
+    }
+    stopped.notify_one();
+    thread.join();
+}
+
+void ProgressReporter::update() {
+    const RunCounts counts = metrics.counts();
+    const Sample now{counts.elapsed, counts.deleted + counts.planned, counts.blocked};
+    const Sample previous = samples.back();
+
+    // The current rate is taken over the last `RATE_WINDOW`, from the newest sample at least that old
+    samples.push_back(now);
+    while (samples.size() > 2 && samples[1].at <= now.at - RATE_WINDOW) samples.pop_front();
+    const Sample& since = samples.front();
+    const double span = seconds(now.at - since.at);
+    Progress progress{counts};
+    progress.current = span > 0 ? static_cast<double>(now.done - since.done) / span : 0;
+    progress.blocked = span > 0 ? std::clamp(seconds(now.blocked - since.blocked) / span, 0.0, 1.0) : 0;
+
+    // Exponential moving average. Until it has a full window of history, the average of the run is closer.
+    const double step = seconds(now.at - previous.at);
+    if (now.at < AVERAGE_WINDOW) {
+        average = seconds(now.at) > 0 ? static_cast<double>(now.done) / seconds(now.at) : 0;
+    } else if (step > 0) {
+        const double rate = static_cast<double>(now.done - previous.done) / step;
+        average += (rate - average) * (1 - std::exp(-step / seconds(AVERAGE_WINDOW)));
+    }
+
+    progress.average = average;
+    on_progress(progress);
+}
@@ -0,0 +1,193 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/ratelimit.hpp>
+#include <include/client.hpp>
+#include <include/metrics.hpp>
+#include <nlohmann/json.hpp>
+#include <charconv>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <algorithm>
+
+namespace {
+    constexpr long RATE_LIMITED_HTTP_CODE = 429;
+    constexpr long ACCEPTED_HTTP_CODE = 202; // Search returns it while the index is not ready yet
+    constexpr auto MAX_SLEEP = std::chrono::milliseconds(100); // Longest sleep before the bucket and the stop flag are looked at again
+
+    template <typename T>
+    bool parse_number(const std::string_view s, T& value) {
+        if (s.empty()) return false;
+        const auto [_, ec] = std::from_chars(s.data(), s.data() + s.size(), value);
+        return ec == std::errc();
+    }
+
+    RateLimiter::clock::duration seconds(const double s) {
+        return std::chrono::duration_cast<RateLimiter::clock::duration>(std::chrono::duration<double>(s));
+    }
+}
+
+RateLimiter::RateLimiter(const std::chrono::milliseconds min_delay) : min_delay(min_delay) {}
+
+RateLimiter::Bucket& RateLimiter::bucket_of(const std::string& route) {
+    // Until Discord tells us the bucket, the route is its own bucket
+    const auto [it, _] = route_buckets.try_emplace(route, route);
+    return buckets[it->second];
+}
+
+RateLimiter::clock::time_point RateLimiter::available_at(const std::string& route, const clock::time_point now, WaitCause& cause) {
+    Bucket& bucket = bucket_of(route);
+    auto wait_until = global_reset_at;
+    cause = WaitCause::GLOBAL;
+
+    if (const auto last = last_requests.find(route); last != last_requests.end() && last->second + min_delay > wait_until) {
+        wait_until = last->second + min_delay;
+        cause = WaitCause::FIXED_DELAY;
+    }
+
+    if (const auto paused = paused_until.find(route); paused != paused_until.end() && paused->second > wait_until) {
+        wait_until = paused->second;
+        cause = WaitCause::BACKOFF;
+    }
+
+    if (bucket.reset_at <= now) { // The window is over, the bucket is full again
+        bucket.remaining = std::max(bucket.remaining, bucket.limit - bucket.in_flight);
+        bucket.reset_at = clock::time_point::max(); // Unknown until the next response
+    }
+    if (bucket.remaining <= 0 && bucket.reset_at > wait_until) {
+        wait_until = bucket.reset_at;
+        cause = bucket.is_indexing ? WaitCause::INDEX : WaitCause::BUCKET;
+    }
+
+    return wait_until;
+}
+
+RateLimiter::clock::time_point RateLimiter::ready_at(const std::string& route, WaitCause* cause) {
+    std::scoped_lock lock(mutex);
+    WaitCause why;
+    const auto at = available_at(route, clock::now(), why);
+    if (cause) *cause = why;
+    return at;
+}
+
+void RateLimiter::reserve(const std::string& route, const clock::time_point now) {
+    Bucket& bucket = bucket_of(route);
+    --bucket.remaining; // The response will correct the count
+    ++bucket.in_flight;
+    last_requests[route] = now;
+    ++request_count;
+}
+
+bool RateLimiter::try_acquire(const std::string& route) {
+    std::scoped_lock lock(mutex);
+    const auto now = clock::now();
+    WaitCause cause;
+    if (available_at(route, now, cause) > now) return false;
+
+    reserve(route, now);
+    return true;
+}
+
+bool RateLimiter::acquire(const std::string& route, Metrics& metrics, const std::atomic<bool>& stop) {
+    std::unique_lock lock(mutex);
+    const auto started = clock::now();
+    auto slept_since = started;
+    WaitCause cause = WaitCause::BUCKET;
+    bool has_slept = false;
+
+    while (true) {
+        const auto now = clock::now();
+        if (has_slept) metrics.waited(cause, now - slept_since); // Blamed on what the last sleep waited for
+        slept_since = now;
+        if (stop) {
+            waited_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(now - started).count();
+            return false;
+        }
+
+        const auto wait_until = available_at(route, now, cause);
+        if (wait_until <= now) {
+            reserve(route, now);
+            waited_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(now - started).count();
+            return true;
+        }
+
+        // Requests in flight on other threads may free the bucket before `wait_until`
+        lock.unlock();
+        std::this_thread::sleep_until(std::min(wait_until, now + MAX_SLEEP));
+        has_slept = true;
+        lock.lock();
+    }
+}
+
+void RateLimiter::pause(const std::string& route, const clock::time_point until) {
+    std::scoped_lock lock(mutex);
+    auto& paused = paused_until[route];
+    paused = std::max(paused, until);
+}
+
+bool RateLimiter::update(const std::string& route, const Response& response) {
+    std::scoped_lock lock(mutex);
+    const auto now = clock::now();
+
+    if (const auto hash = response.header("x-ratelimit-bucket"); !hash.empty()) {
+        // Buckets are shared per major parameter (the part after ':' in the route name)
+        const auto major = route.substr(route.find(':') + 1);
+        route_buckets[route] = std::string(hash) + ':' + major;
+    }
+
+    Bucket& bucket = bucket_of(route);
+    int limit = 0, remaining = 0;
+    double reset_after = 0;
+
+    /*
+     * Concurrent responses arrive in any order, so within a window the lowest count Discord reported is kept.
+     * Requests still in flight have not been counted by Discord yet.
+     */
+    const bool is_same_window = bucket.reset_at != clock::time_point::max() && bucket.reset_at > now;
+    const int reported = bucket.remaining + bucket.in_flight;
+    bucket.in_flight = std::max(bucket.in_flight - 1, 0);
+    if (bucket.reset_at == clock::time_point::max()) bucket.reset_at = now; // Unless the headers tell otherwise
+
+    if (parse_number(response.header("x-ratelimit-limit"), limit)) bucket.limit = limit;
+    if (parse_number(response.header("x-ratelimit-remaining"), remaining))
+        bucket.remaining = (is_same_window ? std::min(reported, remaining) : remaining) - bucket.in_flight;
+    if (parse_number(response.header("x-ratelimit-reset-after"), reset_after)) bucket.reset_at = now + seconds(reset_after);
+    bucket.is_indexing = false;
+
+    if (response.http_code != RATE_LIMITED_HTTP_CODE && response.http_code != ACCEPTED_HTTP_CODE)
+        return false;
+
+    // `Retry-After` is rounded to whole seconds, the body carries the precise value
+    double retry_after = -1;
+    bool is_global = !response.header("x-ratelimit-global").empty();
+    const auto body = nlohmann::json::parse(response.body, nullptr, false);
+
+    if (!body.is_discarded() && body.is_object()) {
+        if (body.contains("retry_after") && body["retry_after"].is_number()) retry_after = body["retry_after"].get<double>();
+        if (body.contains("global") && body["global"].is_boolean()) is_global = is_global || body["global"].get<bool>();
+    }
+    if (retry_after < 0) parse_number(response.header("retry-after"), retry_after);
+
+    if (response.http_code == ACCEPTED_HTTP_CODE && retry_after < 0)
+        return false; // A regular accepted response
+
+    bucket.is_indexing = response.http_code == ACCEPTED_HTTP_CODE;
+    ++(bucket.is_indexing ? index_wait_count : rate_limited_count);
+    const auto retry_at = now + seconds(std::max(retry_after, 0.0));
+    if (is_global) {
+        global_reset_at = std::max(global_reset_at, retry_at);
+    } else {
+        bucket.remaining = 0;
+        bucket.reset_at = std::max(bucket.reset_at, retry_at);
+    }
+
+    return true;
+}
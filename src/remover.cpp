@@ -7,8 +7,27 @@
  */
 
 #include <include/remover.hpp>
+#include <include/job.hpp>
+#include <include/client.hpp>
+#include <include/ratelimit.hpp>
+#include <include/retry.hpp>
+#include <include/queue.hpp>
+#include <include/scheduler.hpp>
+#include <include/shards.hpp>
+#include <include/tombstones.hpp>
+#include <include/message.hpp>
+#include <include/filter.hpp>
+#include <include/journal.hpp>
+#include <include/metrics.hpp>
+#include <include/package.hpp>
+#include <include/plan.hpp>
+#include <include/progress.hpp>
+#include <include/archive.hpp>
+#include <include/cassette.hpp>
 #include <include/helpers.hpp>
+#include <include/logger.hpp>
 #include <include/config.hpp>
+#include <fmt/color.h>
 #include <nlohmann/json.hpp>
 #include <curl/curl.h>
 #include <string>
@@ -17,252 +36,680 @@
 #include <stdexcept>
 #include <chrono>
 #include <thread>
-#include <unordered_set>
+#include <atomic>
+#include <exception>
+#include <optional>
+#include <algorithm>
+#include <deque>
+#include <memory>
 
-using nlohmann::json;
 using Query = std::pair<std::string, std::string>;
 
-const std::string DISCORD_API_URL_BASE = "https://discord.com/api/";
 const std::string DISCORD_API_VERSION = "v10";
-const std::string DISCORD_API_AUTHORIZATION_KEY = "Authorization: ";
 const std::string CURL_GET_METHOD = "GET";
 const std::string CURL_DELETE_METHOD = "DELETE";
+const std::string CURL_POST_METHOD = "POST";
 
-struct Message {
-    std::string id;
-    int type{};
-    std::string content;
+// Request templates, built once per job. Only the snowflake range or channel and message IDs are appended per request.
+struct Endpoints {
+    std::string search;       // Search URL with every query parameter except the snowflake range
+    std::string channels;     // Channels URL, see `ChannelScheduler`
+    std::string search_route; // Rate limit route, see `RateLimiter`
+};
+
+Endpoints build_endpoints(const JobConfig& job, const std::string& api_url_base) {
+    const std::string api_url = api_url_base + DISCORD_API_VERSION;
+    const std::string search_url = is_dm_guild(job.guild_id)
+                            ? api_url + "/channels/" + job.channel_id + "/messages/search?"
+                            : api_url + "/guilds/" + job.guild_id + "/messages/search?";
+    const std::string query = build_search_query(job);
 
-    NLOHMANN_DEFINE_TYPE_INTRUSIVE(Message, id, type);
+    debug("Query Parameters: {}", query);
+
+    return {
+        search_url + query,
+        api_url + "/channels/",
+        "search:" + (is_dm_guild(job.guild_id) ? job.channel_id : job.guild_id)
+    };
+}
 
-    Message(std::string id, int type, std::string content = "") : id(std::move(id)), type(type), content(std::move(content)) {}
-    bool operator==(const Message& other) const { // Required for unordered_set
-        return id == other.id &&
-        type == other.type;
+/*
+ * A job while it runs. Its discovery stage (search, import or plan) runs on its own thread and fills `queue`;
+ * the delete stage of the process takes from the queues of all jobs.
+ */
+struct Job {
+    Job(const JobConfig& config, const size_t number, const RemoverConfig& settings, const std::atomic<bool>& cancelled,
+        Metrics& metrics, ConnectionPool& connections, Cassette& cassette, Tombstones& tombstones, ArchiveWriter* archive)
+        : config(config), number(number), settings(settings), cancelled(cancelled), metrics(metrics), connections(connections),
+          cassette(cassette), endpoints(build_endpoints(config, settings.api_url)),
+          channels(endpoints.channels, config.bulk_delete && !is_dm_guild(config.guild_id)), tombstones(tombstones),
+          archive(config.plan_path.empty() ? archive : nullptr) {}
+
+    // Nothing is left to delete: the job failed, or everything it found has been handled.
+    bool is_finished() { return error || (channels.empty() && queue.is_drained()); }
+
+    // The discovery stage should end: the job has stopped, or the run is cancelled.
+    bool is_stopping() const { return stop || cancelled; }
+
+    // Ends the discovery stage, what is still queued stays in the journal.
+    void stop_discovery() {
+        stop = true;
+        queue.close();
     }
+
+    const JobConfig& config;
+    const size_t number; // Position in the run, identifies the job's claims in `tombstones`
+    const RemoverConfig& settings;      // Of the run
+    const std::atomic<bool>& cancelled; // See `Remover::cancel`
+    Metrics& metrics;                   // Of the run, shared by its jobs
+    ConnectionPool& connections;
+    Cassette& cassette;
+    const Endpoints endpoints;
+    BoundedQueue<Message> queue{QUEUE_LIMIT};
+    ChannelScheduler channels;
+    Tombstones& tombstones; // Shared by the jobs of the run
+    ArchiveWriter* archive; // `--archive`, none for a dry run
+    std::optional<Journal> journal;
+    std::optional<PlanWriter> plan; // Dry run, the delete stage only records
+    std::atomic<bool> stop = false;
+    std::exception_ptr error;           // Why the job stopped, set on the delete stage's thread
+    std::exception_ptr discovery_error; // Set by the discovery thread
+    JobStats stats;
+    std::thread discovery;
 };
 
-template<> struct std::hash<Message> // Required for unordered_set
-{
-    std::size_t operator()(const Message& m) const noexcept {
-        const std::size_t h1 = std::hash<std::string>{}(m.id);
-        const std::size_t h2 = std::hash<int>{}(m.type);
-        return h1 ^ (h2 << 1);
+// Fetches one page of results. Returns false if the run is cancelled before the page is received.
+bool search(Client& client, RateLimiter& limiter, RetryPolicy& retries, Metrics& metrics, const std::atomic<bool>& cancelled,
+            const Endpoints& endpoints, const SnowflakeRange& range, SearchPage& page, const bool keep_content, const bool keep_raw) {
+    debug("[Search] Parameters: min_id = {}, max_id = {}", range.min_id, range.max_id);
+
+    std::string url = endpoints.search;
+    if (range.min_id != 0) url += "&min_id=" + std::to_string(range.min_id);
+    if (range.max_id != UINT64_MAX) url += "&max_id=" + std::to_string(range.max_id);
+    debug("Full URL: {}", url);
+
+    uint8_t attempts = 0, rate_limited = 0;
+    while (true) {
+        if (!limiter.acquire(endpoints.search_route, metrics, cancelled)) return false;
+        verbose("Search: Sending request...");
+        const Response& response = client.request(url, CURL_GET_METHOD);
+        metrics.request(Endpoint::SEARCH, response);
+        const bool is_rate_limited = limiter.update(endpoints.search_route, response); // Rate limited, or the search index is not ready yet
+        const Failure failure = classify(response, is_rate_limited);
+        if (failure == Failure::CANCELLED) return false;
+
+        if (retries.should_retry(endpoints.search_route, failure, attempts)) {
+            verbose(WARNING, "Search: {}! Retrying...", failure_reason(response));
+            continue;
+        }
+
+        if (response.result != CURLE_OK)
+            throw std::runtime_error("Failed to send search request: " + failure_reason(response) + '.');
+        debug("Response: {}, Code: {}", response.body, response.http_code);
+
+        if (is_rate_limited) {
+            if (++rate_limited >= RetryPolicy::MAX_RATE_LIMITED)
+                throw std::runtime_error("Search is still rate limited or waiting for the search index after " + std::to_string(rate_limited) + " attempts.");
+            verbose(WARNING, "Search: Rate limited by Discord API! Retrying when allowed...");
+            continue;
+        }
+
+        if (response.http_code == 401) throw std::invalid_argument("Token is invalid or expired.");
+        if (is_http_error(response.http_code)) throw std::runtime_error("Failed to search messages.");
+
+        parse_search_page(response.body, page, keep_content, keep_raw);
+        return true;
     }
-};
+}
 
-json search(const unsigned short offset) {
-    debug(IS_DEBUG, std::string("[Search] Parameters: offset = " + std::to_string(offset)));
-    const std::string api_url = is_dm_guild(GUILD_ID)
-                            ? DISCORD_API_URL_BASE + DISCORD_API_VERSION + "/channels/" + CHANNEL_ID + "/messages/"
-                            : DISCORD_API_URL_BASE + DISCORD_API_VERSION + "/guilds/" + GUILD_ID + "/messages/";
+void display_message(const Message& message, const unsigned int length) {
+    const auto& c = message.content;
+    size_t i = 0;
+    for (unsigned int cp = 0; i < c.size() && cp < length; ++i)
+        if ((static_cast<unsigned char>(c[i]) & 0xC0) != 0x80) ++cp;
+    while (i < c.size() && (static_cast<unsigned char>(c[i]) & 0xC0) == 0x80) ++i;
+    const auto text = std::string_view(c).substr(0, i);
+    if (i < c.size())
+        info("Message: {}{}", text, fmt::styled("...", fmt::fg(fmt::color::gray)));
+    else
+        info("Message: {}", text);
+}
 
-    const std::vector<Query> params = construct_query_params(std::to_string(offset));
-    const std::string query = build_query_string(params);
-    const std::string auth_header = DISCORD_API_AUTHORIZATION_KEY + DISCORD_TOKEN;
-    std::string response;
+// Checks a delete message response. Returns false if the message was skipped and stays in the channel.
+bool check_delete(const Response& sent) {
+    constexpr int ARCHIVED_THREAD_CODE = 50083;
+    constexpr int UNKNOWN_MESSAGE_CODE = 10008;
 
-    debug(IS_DEBUG, "Query Parameters: " + query);
+    if (sent.result != CURLE_OK)
+        throw std::runtime_error("Failed to send delete message request: " + failure_reason(sent) + '.');
+    debug("Response: {}, Code: {}", sent.body, sent.http_code);
 
-    const std::string url = api_url + "search?" + query;
-    debug(IS_DEBUG, "Full URL: " + url);
+    const long http_code = sent.http_code;
 
-    log(IS_VERBOSE, "Search: Sending request...");
-    auto [curl, result] = send_request(response, auth_header, url, CURL_GET_METHOD);
-    long http_code = 0;
+    if (http_code == 400 || http_code == 404) {
+        const int code = discord_error_code(sent);
+        if (code == ARCHIVED_THREAD_CODE) {
+            verbose(WARNING, "Delete Message: Cannot remove archived thread. Skipping...");
+            return false;
+        }
+        if (code == UNKNOWN_MESSAGE_CODE) { // e.g. deleted before an interrupted run stopped
+            verbose(WARNING, "Delete Message: Message is already deleted.");
+            return true;
+        }
+    }
+    else if (http_code == 403) throw std::invalid_argument("Don't have access to that message.");
 
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+    if (is_http_error(http_code)) {
+        throw std::runtime_error("Failed to delete message: " + failure_reason(sent) + '.');
+    }
 
-    if (result != CURLE_OK)
-        throw std::runtime_error("Failed to send search request.");
-    debug(IS_DEBUG, "Response: " + response + ", Code: " + std::to_string(http_code));
+    verbose("Delete Message: Message deleted successfully!");
+    return true;
+}
 
-    curl_easy_cleanup(curl);
+std::string bulk_delete_body(const std::vector<Message>& batch) {
+    std::string body = R"({"messages":[)";
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (i) body += ',';
+        body += '"' + std::to_string(batch[i].id) + '"';
+    }
+    body += "]}";
+    return body;
+}
 
-    if (http_code == 401) throw std::invalid_argument("Token is invalid or expired.");
-    if (is_http_error(http_code)) throw std::runtime_error("Failed to search messages.");
+/*
+ * Checks a bulk delete response (2-100 messages of one channel, needs Manage Messages in the channel).
+ * Returns false if the batch was refused and has to be deleted message by message.
+ */
+bool check_bulk_delete(Channel& channel, const Response& sent, const size_t count) {
+    constexpr int TOO_OLD_CODE = 50034;
 
-    json json_response = json::parse(response);
+    if (sent.result != CURLE_OK)
+        throw std::runtime_error("Failed to send bulk delete request: " + failure_reason(sent) + '.');
+    debug("Response: {}, Code: {}", sent.body, sent.http_code);
 
-    if (json_response.contains("retry_after")) { // Rate limited by discord
-        log(IS_VERBOSE, "Search: Rate limited by Discord API! Trying again later...", WARNING);
-        handle_rate_limit(json_response);
-        log(IS_VERBOSE, "Search: Retrying...", WARNING);
-        json_response = search(offset); // Retry
+    if (sent.http_code == 403) { // No Manage Messages here, not worth asking again
+        verbose(WARNING, "Bulk Delete: Not allowed in this channel. Deleting one by one...");
+        channel.bulk = Channel::Bulk::DENIED;
+        return false;
+    }
+    if (sent.http_code == 400 && discord_error_code(sent) == TOO_OLD_CODE) {
+        verbose(WARNING, "Bulk Delete: Some messages are too old. Deleting one by one...");
+        return false;
     }
+    if (is_http_error(sent.http_code)) throw std::runtime_error("Failed to bulk delete messages: " + failure_reason(sent) + '.');
 
-    return json_response;
+    channel.bulk = Channel::Bulk::ALLOWED;
+    verbose("Bulk Delete: {} messages deleted successfully!", count);
+    return true;
 }
 
-void delete_message(const Message& message) {
-    constexpr unsigned short RATE_LIMITED_HTTP_CODE = 429;
-    constexpr unsigned short ARCHIVED_THREAD_CODE = 50083;
+// Archive record of a message from a data package, which has no search result: what the package has of it.
+std::string import_record(const Message& m) {
+    return nlohmann::json{{"id", std::to_string(m.id)}, {"channel_id", std::to_string(m.channel_id)}, {"content", m.content}}.dump();
+}
 
-    debug(IS_DEBUG, std::string("[Delete Message] Parameters: Message (ID) = " + message.id));
+// Filters, journals and queues a message found by the discovery stage of a job. Returns false once the job stops.
+bool enqueue(Job& job, Message& m, Transport& transport) {
+    if (job.is_stopping()) return false;
+    if (job.journal && job.journal->state().done.contains(m.id)) return true; // Finished before the run was resumed
+    if (is_excluded(m.features, job.config.rules)) {
+        if (job.journal) job.journal->skipped(m.id);
+        job.metrics.skipped();
+        return true;
+    }
 
-    if (is_system_message(message.type)) { // Redundant, but left for safety
-        log(IS_VERBOSE, "Delete Message: System message. Skipping...", WARNING);
-        return; // Cannot remove system message
+    // Deleted, but still in the search index, or found by another job too. A dry run claims nothing.
+    if (job.plan ? job.tombstones.is_taken(m.id, job.number) : !job.tombstones.claim(m.id, job.number)) {
+        job.metrics.stale();
+        return true;
     }
 
-    const std::string delete_api_url = DISCORD_API_URL_BASE + DISCORD_API_VERSION + "/channels/" + CHANNEL_ID + "/messages/" + message.id;
-    const std::string auth_header = DISCORD_API_AUTHORIZATION_KEY + DISCORD_TOKEN;
-    std::string response;
-    debug(IS_DEBUG, "Full URL: " + delete_api_url);
-
-    if (IS_DISPLAY) {
-        const auto& c = message.content;
-        size_t i = 0;
-        for (unsigned int cp = 0; i < c.size() && cp < DISPLAY_LENGTH; ++i)
-            if ((static_cast<unsigned char>(c[i]) & 0xC0) != 0x80) ++cp;
-        while (i < c.size() && (static_cast<unsigned char>(c[i]) & 0xC0) == 0x80) ++i;
-        const auto text = std::string_view(c).substr(0, i);
-        if (i < c.size())
-            fmt::print("Message: {}{}\n", text, fmt::styled("...", fmt::fg(fmt::color::gray)));
-        else
-            fmt::print("Message: {}\n", text);
+    if (job.archive) { // Written by the time the delete stage gets to the message
+        m.archived = job.archive->add(m.id, m.raw.empty() ? import_record(m) : std::move(m.raw));
+        m.raw = {};
     }
 
-    log(IS_VERBOSE, "Delete Message: Sending request...");
+    if (job.journal) job.journal->queued(m.id);
+    if (!job.queue.push(std::move(m))) return false; // The delete stage has stopped the job
+    job.metrics.queued();
+    transport.wakeup(); // The delete stage may be waiting for messages
+    return true;
+}
+
+/*
+ * Searches the shards of a job's search stage until none is left.
+ *
+ * Each shard is walked with a snowflake cursor instead of an offset: every search asks for messages
+ * older than the oldest one seen so far (`max_id`). Each page of history is fetched once, no matter
+ * how many messages are skipped or still waiting in the search index after their deletion.
+ * Results that are already deleted or claimed by another job (see `Tombstones`) move the cursor like any other,
+ * but are not queued and do not count as work left when deciding whether to split the shard.
+ */
+void search_worker(RateLimiter& limiter, RetryPolicy& retries, Job& job, Transport& transport, ShardQueue& shards) {
+    Client client(job.settings.token, job.connections, job.cassette, job.cancelled);
+    SnowflakeRange shard;
+    SearchPage page;
+    bool is_initial = false;
 
-    auto [curl, result] = send_request(response, auth_header, delete_api_url, CURL_DELETE_METHOD);
-    long http_code = 0;
+    while (shards.take(shard, is_initial)) {
+        while (true) {
+            if (job.is_stopping() || shards.is_stopping()) return; // Another worker has failed
 
-    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
-    curl_easy_cleanup(curl);
+            try {
+                if (!search(client, limiter, retries, job.metrics, job.cancelled, job.endpoints, shard, page, job.settings.display, job.archive != nullptr))
+                    return; // Cancelled, the shard is not journaled as searched
+            } catch (const std::exception& e) {
+                if (job.config.skip_if_fail) { // Not journaled as searched, so a resumed run tries it again
+                    verbose(WARNING, "Search failed: {}! Skipping the rest of the time range...", e.what());
+                    break;
+                }
 
-    debug(IS_DEBUG, "Response: " + response + ", Code: " + std::to_string(http_code));
+                throw;
+            }
 
-    if (result != CURLE_OK)
-        throw std::runtime_error("Failed to send delete message request.");
+            debug("Search: {} messages of {}", page.messages.size(), page.total_results);
 
-    if (http_code == RATE_LIMITED_HTTP_CODE) { // Rate limited by Discord API
-        try {
-            const json j = json::parse(response);
-            log(IS_VERBOSE, "Delete Message: Rate limited by Discord API! Trying again later...", WARNING);
-            handle_rate_limit(j);
-            log(IS_VERBOSE, "Delete Message: Retrying...", WARNING);
-            delete_message(message); // Retry
-        } catch (const json::exception& _) {
-            throw std::runtime_error("Failed to parse rate limit JSON.");
+            // Results outside the shard belong to another one, they are found there
+            std::erase_if(page.messages, [&](const Message& m) { return m.id <= shard.min_id || m.id >= shard.max_id; });
+            if (is_initial) job.metrics.expected(page.total_results); // Covers the whole shard, its parts split off later included
+            is_initial = false;
+            job.metrics.found(page.messages.size());
+
+            // All messages of the shard removed
+            if (page.messages.empty()) {
+                if (job.journal) job.journal->page(shard);
+                break;
+            }
+
+            const uint64_t oldest = std::ranges::min(page.messages, {}, &Message::id).id;
+
+            const auto stale = static_cast<unsigned int>(std::erase_if(page.messages, [&](const Message& m) { return job.tombstones.is_taken(m.id, job.number); }));
+            if (stale) {
+                debug("Search: {} results are already deleted", stale);
+                job.metrics.stale(stale);
+            }
+
+            // Parse Messages
+            verbose("Remover: Parsing the messages...");
+
+            /*
+             * I want to note why we handle search parameters here:
+             * If we used the search API with the `has` parameter, text messages would disappear
+             * from the results. Because of this they will be just skipped as system messages.
+             */
+            for (auto& m : page.messages)
+                if (!enqueue(job, m, transport)) return; // Not journaled, a resumed run searches the page again
+
+            // Journaled after its messages, so a page in the journal has all of them queued or skipped before it
+            if (job.journal) job.journal->page({oldest - 1, shard.max_id});
+
+            shard.max_id = oldest; // The next page starts below the oldest message
+            shards.split(shard, page.total_results - std::min(stale, page.total_results));
         }
+        shards.finish();
     }
+}
 
-    if (http_code == 400 && !response.empty()) {
+/*
+ * Search stage of a job.
+ *
+ * The date range is searched as time shards (see `ShardQueue`) by up to `SEARCH_WORKERS` threads at once,
+ * all within the search rate limit. A resumed job only searches what its journal has not covered yet.
+ */
+void search_stage(RateLimiter& limiter, RetryPolicy& retries, Job& job, Transport& transport) {
+    const SnowflakeRange range = search_range(job.config);
+    ShardQueue shards(job.journal ? subtract_ranges(range, job.journal->state().searched) : std::vector{range});
+    std::vector<std::exception_ptr> errors(SEARCH_WORKERS);
+
+    const auto work = [&, level = log_level()](const size_t worker) {
+        const LogLevelScope log_scope(level);
         try {
-            const json j = json::parse(response);
-            if (j.contains("code") && j["code"] == ARCHIVED_THREAD_CODE) {
-                log(IS_VERBOSE, "Delete Message: Cannot remove archived thread. Skipping...", WARNING);
-                return;
-            }
-        } catch (const json::exception& _) {
-            throw std::runtime_error("Failed to parse error JSON.");
+            search_worker(limiter, retries, job, transport, shards);
+        } catch (...) {
+            errors[worker] = std::current_exception();
         }
-    }
-    else if (http_code == 403) throw std::invalid_argument("Don't have access to that message.");
+        shards.stop(); // Everything is searched or the job has ended, either way the other workers are done too
+    };
 
-    if (is_http_error(http_code)) {
-        throw std::runtime_error("Failed to delete message.");
-    }
+    std::vector<std::thread> helpers;
+    for (size_t worker = 1; worker < SEARCH_WORKERS; ++worker) helpers.emplace_back(work, worker);
+    work(0);
+    for (auto& helper : helpers) helper.join();
+
+    for (const auto& error : errors)
+        if (error) std::rethrow_exception(error);
+}
 
-    log(IS_VERBOSE, "Delete Message: Message deleted successfully!");
+/*
+ * Replaces the search stage when the job has `--import`: the message IDs come from a data package,
+ * and no search request is sent at all.
+ */
+void import_stage(Job& job, Transport& transport) {
+    read_data_package(job.config.import_path, job.config, job.settings.display || job.archive, [&](Message& m) {
+        job.metrics.found();
+        return enqueue(job, m, transport);
+    });
 }
 
-void discord_rm() {
-    log(IS_VERBOSE, "Remover: Searching for messages to delete...");
+// Replaces the search stage when the job has `--execute-plan`. The filters apply again, so they can be narrowed.
+void plan_stage(Job& job, Transport& transport) {
+    read_plan(job.config.execute_plan_path, [&](Message& m) {
+        job.metrics.found();
+        return enqueue(job, m, transport);
+    });
+}
 
-    unsigned int offset = 0;
-    std::unordered_set<Message> skipped_messages_set; // all-time skipped messages
-    json messages;
+// Opens the journal or plan of a job and starts its discovery thread. A job that cannot start fails on its own.
+void start_job(Job& job, RateLimiter& limiter, RetryPolicy& retries, Transport& transport) {
+    const JobConfig& config = job.config;
+    try {
+        if (!config.journal_path.empty()) {
+            job.journal.emplace(config.journal_path, config.resume, run_header(config));
+            for (const uint64_t id : job.journal->state().deleted) job.tombstones.bury(id);
+            if (config.resume)
+                verbose("Remover: Resuming `{}`, {} messages were already processed.", config.name, job.journal->state().done.size());
+        }
+        if (!config.plan_path.empty()) job.plan.emplace(config.plan_path, config, job.settings.delay);
+    } catch (const std::exception&) {
+        job.error = std::current_exception();
+        job.stop_discovery();
+        return;
+    }
 
-    while (true) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(DELAY_IN_MS)); // Delay to not hit rate limit
+    // Next pages are searched while the current one is being deleted
+    job.discovery = std::thread([&job, &limiter, &retries, &transport] {
+        const LogLevelScope log_scope(job.settings.log_level);
         try {
-            messages = search(offset);
-            debug(IS_DEBUG, std::string("Messages [JSON]:\n") + messages.dump());
-        } catch (const std::exception& e) {
-            if (IS_SKIP_IF_FAIL) {
-                std::string err_msg = static_cast<std::string>("Search failed: ") + e.what() + "! Skipping...";
-                log(IS_VERBOSE, err_msg, WARNING);
-                continue;
-            }
+            if (!job.config.execute_plan_path.empty()) plan_stage(job, transport);
+            else if (!job.config.import_path.empty()) import_stage(job, transport);
+            else search_stage(limiter, retries, job, transport);
+        } catch (...) {
+            job.discovery_error = std::current_exception();
+        }
+        job.queue.close();
+        transport.wakeup();
+    });
+}
 
-            throw;
+/*
+ * Delete stage of the pipeline, shared by all jobs. Runs until every job is finished.
+ *
+ * In guild-wide mode the results come from many channels, and every channel has its own delete bucket.
+ * Messages are sorted into per-channel queues, and the next deletion goes to the channel that is ready first.
+ * Bulk delete only exists in guild channels. Jobs take turns in the same way, so a job whose buckets are empty
+ * does not hold up the others.
+ *
+ * Requests are asynchronous: every channel whose bucket has room gets a request in flight (up to `MAX_IN_FLIGHT`),
+ * so the throughput is bound by the rate limits and not by the round trip time. Responses are handled
+ * on this thread as they arrive; a rate limited batch goes back to the front of its channel, and so does
+ * a batch that hit a network or server error, until it has used up its attempts (see `RetryPolicy`).
+ */
+void delete_stage(RateLimiter& limiter, RetryPolicy& retries, Transport& transport, Metrics& metrics, std::deque<Job>& jobs,
+                  const RemoverConfig& settings, const std::atomic<bool>& cancelled) {
+    constexpr auto POLL_INTERVAL = std::chrono::milliseconds(50); // Longest wait before the stop request is looked at
+
+    const size_t buffered_limit = std::max<size_t>(QUEUE_LIMIT, ChannelScheduler::BULK_DELETE_LIMIT);
+
+    const auto notify = [&](const RemoverEvent::Type type, const Job& job, const Message& m, std::string error = {}) {
+        if (settings.on_event) settings.on_event({type, job.number, m.id, m.channel_id, std::move(error)});
+    };
+    const auto deleted = [&](Job& job, const Message& m) {
+        job.tombstones.bury(m.id);
+        ++job.stats.deleted;
+        metrics.deleted();
+        if (job.journal) job.journal->deleted(m.id);
+        notify(RemoverEvent::Type::DELETED, job, m);
+    };
+    const auto not_deletable = [&](Job& job, const Message& m) {
+        ++job.stats.failed;
+        metrics.failed();
+        if (job.journal) job.journal->failed(m.id, "not deletable");
+        notify(RemoverEvent::Type::FAILED, job, m, "not deletable");
+    };
+    // Called from a catch block: stops the job, or skips the batch with `--skip-if-fail`
+    const auto failed = [&](Job& job, const std::vector<Message>& batch, const std::exception& e, const char* stage) {
+        job.stats.failed += batch.size();
+        metrics.failed(batch.size());
+        for (const auto& m : batch) {
+            if (job.journal) job.journal->failed(m.id, e.what());
+            notify(RemoverEvent::Type::FAILED, job, m, e.what());
+        }
+        if (!job.config.skip_if_fail) {
+            job.error = std::current_exception();
+            job.stop_discovery();
+            return;
         }
 
-        const unsigned int total_results = messages["total_results"].get<int>();
-
-        // Parse Messages
-        log(IS_VERBOSE, "Remover: Parsing the messages...");
-        std::vector<Message> msgs;
-        unsigned char skipped_messages = 0, deleted_messages = 0; // skipped and deleted messages in current page
-
-        /*
-         * I want to note why we handle search parameters here:
-         * If we used the search API with the `has` parameter, text messages would disappear
-         * from the results. Because of this they will be just skipped as system messages.
-         */
-        for (const auto msg_group = messages["messages"]; const auto& msg : msg_group) {
-            if (!msg[0].contains("id")) continue; // We want to parse only user messages
-
-            std::string content = msg[0].contains("content") ? msg[0]["content"].get<std::string>() : "";
-            Message m(msg[0]["id"].get<std::string>(), msg[0]["type"].get<int>(), content);
-
-            std::string content_type;
-            const auto attachments = msg[0]["attachments"], embeds = msg[0]["embeds"];
-            const bool attachments_empty = attachments.empty(), embeds_empty = embeds.empty(), is_poll = msg[0].contains("poll");
-            bool snapshots_empty = msg[0].contains("message_snapshots") ? msg[0]["message_snapshots"].empty() : true;
-            bool stickers_items_empty = msg[0].contains("sticker_items") ? msg[0]["sticker_items"].empty() : true;
-
-            if (!attachments_empty && attachments[0].contains("content_type")) content_type = attachments[0]["content_type"].get<std::string>();
-            if (!embeds_empty) const auto type = embeds[0]["type"].get<std::string>();
-
-            // sorry... at least it works
-            if (is_system_message(m.type) ||
-                (is_poll && NO_POLL) ||
-                (!embeds_empty && NO_EMBED) ||
-                (!embeds_empty && embeds[0]["type"] == "link" && NO_LINK) ||
-                (!attachments_empty && content_type.empty() && NO_FILE) ||
-                (!attachments_empty && content_type.starts_with("image") && NO_IMAGE) ||
-                (!attachments_empty && content_type.starts_with("video") && NO_VIDEO) ||
-                (!attachments_empty && content_type.starts_with("audio") && NO_SOUND) ||
-                (!stickers_items_empty && NO_STICKER) ||
-                (!snapshots_empty && NO_FORWARD))
-            {
-                ++skipped_messages;
-                skipped_messages_set.insert(m);
-                continue;
+        verbose(WARNING, "{} failed: {}! Skipping...", stage, e.what());
+    };
+    // Puts the batch back after a transient failure. Returns false if it has no attempts left, or the failure is not transient.
+    const auto requeue = [&](Job& job, Channel& channel, const std::string& route, const Failure failure, const Response& response,
+                             std::vector<Message>& batch, const bool singly, const char* stage) {
+        uint8_t attempts = std::ranges::max(batch, {}, &Message::attempts).attempts;
+        if (!retries.should_retry(route, failure, attempts)) return false;
+
+        for (auto& m : batch) m.attempts = attempts;
+        verbose(WARNING, "{}: {}! Retrying...", stage, failure_reason(response));
+        job.channels.retry(channel, batch, singly);
+        return true;
+    };
+
+    const auto start = [&](Job& job, Channel& channel, std::vector<Message> batch) {
+        if (job.archive) { // Nothing is deleted before it is archived
+            try {
+                job.archive->wait(std::ranges::max(batch, {}, &Message::archived).archived);
+            } catch (const std::exception& e) {
+                failed(job, batch, e, "Archive");
+                return;
             }
+        }
 
-            msgs.emplace_back(m);
+        if (batch.size() > 1) {
+            debug("[Bulk Delete] Parameters: Channel (ID) = {}, Messages = {}", channel.id, batch.size());
+            const std::string body = bulk_delete_body(batch);
+            debug("Full URL: {}, Body: {}", channel.bulk_delete, body);
+            if (settings.display)
+                for (const auto& message : batch) display_message(message, settings.display_length);
+
+            verbose("Bulk Delete: Sending request...");
+            transport.submit(channel.bulk_delete, CURL_POST_METHOD, body, [&, j = &job, ch = &channel, batch = std::move(batch)](const Response& response) mutable {
+                metrics.request(Endpoint::BULK_DELETE, response);
+                const Failure failure = classify(response, limiter.update(ch->bulk_route, response));
+                if (failure == Failure::RATE_LIMITED) {
+                    verbose(WARNING, "Bulk Delete: Rate limited by Discord API! Retrying when allowed...");
+                    j->channels.retry(*ch, batch, false);
+                    return;
+                }
+                if (failure == Failure::CANCELLED) { // Still queued in the journal
+                    j->channels.retry(*ch, batch, false);
+                    return;
+                }
+                if (requeue(*j, *ch, ch->bulk_route, failure, response, batch, false, "Bulk Delete")) return;
+                try {
+                    if (check_bulk_delete(*ch, response, batch.size())) {
+                        for (const auto& m : batch) deleted(*j, m);
+                        return;
+                    }
+                    j->channels.retry(*ch, batch, true);
+                } catch (const std::exception& e) {
+                    failed(*j, batch, e, "Bulk Delete");
+                }
+            });
+            return;
         }
 
-        // All messages removed
-        if (total_results <= skipped_messages_set.size()) break;
-        if (offset == total_results) break;
+        const Message& message = batch.front();
+        debug("[Delete Message] Parameters: Message (ID) = {}", message.id);
+        if (is_system_message(message.type)) { // Redundant, but left for safety
+            verbose(WARNING, "Delete Message: System message. Skipping...");
+            not_deletable(job, message);
+            return;
+        }
 
-        for (const auto& msg: msgs) {
+        const std::string delete_api_url = channel.messages + std::to_string(message.id);
+        debug("Full URL: {}", delete_api_url);
+        if (settings.display) display_message(message, settings.display_length);
+
+        verbose("Delete Message: Sending request...");
+        transport.submit(delete_api_url, CURL_DELETE_METHOD, {}, [&, j = &job, ch = &channel, batch = std::move(batch)](const Response& response) mutable {
+            metrics.request(Endpoint::DELETE, response);
+            const Failure failure = classify(response, limiter.update(ch->delete_route, response));
+            if (failure == Failure::RATE_LIMITED) {
+                verbose(WARNING, "Delete Message: Rate limited by Discord API! Retrying when allowed...");
+                j->channels.retry(*ch, batch, true);
+                return;
+            }
+            if (failure == Failure::CANCELLED) { // Still queued in the journal
+                j->channels.retry(*ch, batch, true);
+                return;
+            }
+            if (requeue(*j, *ch, ch->delete_route, failure, response, batch, true, "Delete Message")) return;
             try {
-                std::this_thread::sleep_for(std::chrono::milliseconds(DELAY_IN_MS_DEFAULT)); // Delay to not hit rate limit
-                delete_message(msg);
-                ++deleted_messages;
+                if (check_delete(response)) deleted(*j, batch.front());
+                else not_deletable(*j, batch.front());
             } catch (const std::exception& e) {
-                if (IS_SKIP_IF_FAIL) {
-                    std::string err_msg = static_cast<std::string>("Delete Message failed: ") + e.what() + "! Skipping...";
-                    log(IS_VERBOSE, err_msg, WARNING);
+                failed(*j, batch, e, "Delete Message");
+            }
+        });
+    };
+
+    Message msg;
+    std::vector<Message> batch;
+    size_t turn = 0; // Job asked first for the next request, for round robin
+    while (true) {
+        for (Job& job : jobs) {
+            if (job.error) continue;
+            while (!cancelled && job.channels.size() < buffered_limit && job.queue.try_pop(msg)) {
+                if (!job.plan) {
+                    job.channels.push(std::move(msg));
                     continue;
                 }
+                job.plan->add(msg);
+                ++job.stats.planned;
+                metrics.planned();
+            }
+        }
 
-                throw;
+        while (!cancelled && transport.in_flight() < MAX_IN_FLIGHT) {
+            Channel* channel = nullptr;
+            size_t n = 0;
+            for (; n < jobs.size() && !channel; ++n) {
+                Job& job = jobs[(turn + n) % jobs.size()];
+                if (!job.error) channel = job.channels.try_pop(limiter, batch);
+            }
+            if (!channel) break; // Every bucket is empty
+
+            Job& job = jobs[(turn + n - 1) % jobs.size()];
+            turn = (turn + n) % jobs.size();
+            start(job, *channel, std::move(batch));
+        }
+
+        if (transport.in_flight() == 0) {
+            if (cancelled) break; // The rest is still queued in the journals
+            if (std::ranges::all_of(jobs, [](Job& job) { return job.is_finished(); })) break; // Everything is searched and deleted
+        }
+
+        // Wait for a response, the next free bucket or new messages, whichever comes first
+        const auto now = RateLimiter::clock::now();
+        auto until = now + POLL_INTERVAL;
+        WaitCause cause = WaitCause::BUCKET;
+        bool is_throttled = false; // Messages are waiting for a bucket, not for the search
+        for (const Job& job : jobs) {
+            if (job.error || job.channels.empty()) continue;
+
+            WaitCause why = WaitCause::BUCKET;
+            if (const auto at = job.channels.ready_at(limiter, &why); at < until) {
+                until = at;
+                cause = why;
             }
+            is_throttled = true;
+        }
+        const auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(std::max(until - now, RateLimiter::clock::duration::zero()));
+
+        if (transport.in_flight() == 0 && is_throttled) { // Nothing to do but wait for the buckets
+            metrics.waited(cause, timeout);
+            metrics.blocked(timeout);
+        }
+        transport.poll(timeout);
+    }
+}
+
+std::string describe(const std::exception_ptr& error) {
+    try {
+        std::rethrow_exception(error);
+    } catch (const std::exception& e) {
+        return e.what();
+    } catch (...) {
+        return "Unknown error.";
+    }
+}
+
+RunStats Remover::run() {
+    const LogLevelScope log_scope(config.log_level); // The threads of the run take it over
+    verbose("Remover: Searching for messages to delete...");
+
+    Cassette cassette; // Outlives the clients and the transport
+    if (!config.record_path.empty()) cassette.record_to(config.record_path, config.api_url);
+    else if (!config.replay_path.empty()) cassette.replay_from(config.replay_path, config.api_url, config.replay_fast);
+
+    run_metrics.reset();
+    std::optional<MetricsReporter> reporter; // Destroyed last, so the final report covers the whole run
+    if (!config.metrics_path.empty()) reporter.emplace(run_metrics, config.metrics_path);
+
+    const auto limiter_ptr = config.limiter ? config.limiter : std::make_shared<RateLimiter>(config.delay);
+    const auto connections = config.connections ? config.connections : std::make_shared<ConnectionPool>();
+    RateLimiter& limiter = *limiter_ptr;
+
+    RetryPolicy retries(limiter);
+    Tombstones tombstones(config.jobs.size());
+    std::optional<ArchiveWriter> archive; // Shared by the jobs, outlives their threads
+    if (!config.archive_path.empty()) archive.emplace(config.archive_path);
+    std::deque<Job> jobs; // A deque, jobs are referenced by their threads and requests
+    RunStats stats;
+
+    for (const JobConfig& job : config.jobs)
+        jobs.emplace_back(job, jobs.size(), config, cancelled, run_metrics, *connections, cassette, tombstones, archive ? &*archive : nullptr);
+    Transport transport(config.token, *connections, cassette, cancelled); // Destroyed before the jobs, no callback outlives them
+
+    // Stops the discovery threads that are still running and waits for them
+    const auto join_discovery = [&] {
+        for (Job& job : jobs) {
+            job.stop_discovery();
+            if (job.discovery.joinable()) job.discovery.join();
         }
+    };
+
+    try {
+        std::optional<ProgressReporter> progress; // Stopped before the outcome is reported
+        if (config.on_progress) progress.emplace(run_metrics, config.progress_interval, config.on_progress);
 
-        if (offset + skipped_messages >= deleted_messages) offset += skipped_messages - deleted_messages;
-        if (deleted_messages <= 0 && skipped_messages <= 0) { // Return back with delay
-            // This means Discord hasn't updated the data yet, so we wait 10 times longer to minimize requests
-            log(IS_VERBOSE, "Remover: Discord hasn't update the data yet, waiting 10 times longer to minimize requests...", WARNING);
-            std::this_thread::sleep_for(std::chrono::milliseconds(std::max(DELAY_IN_MS_DEFAULT * 10, DELAY_IN_MS * 10)));
-            offset = 0;
-        };
+        for (Job& job : jobs) start_job(job, limiter, retries, transport);
+        delete_stage(limiter, retries, transport, run_metrics, jobs, config, cancelled);
+    } catch (...) {
+        join_discovery();
+        throw; // The journals are flushed when they go out of scope
     }
+
+    // Interrupted: the requests in flight have finished, the rest stays queued for `--resume`
+    join_discovery();
+    for (Job& job : jobs) {
+        if (job.journal) job.journal->flush();
+        if (const auto error = job.error ? job.error : job.discovery_error) job.stats.error = describe(error);
+        else if (job.plan) job.stats.plan_summary = job.plan->finish();
+        if (config.on_event) config.on_event({RemoverEvent::Type::JOB_FINISHED, job.number, 0, 0, job.stats.error});
+        stats.jobs.push_back(std::move(job.stats));
+    }
+
+    // From the metrics of the run, a shared limiter also counts the requests of other runs
+    stats.interrupted = cancelled;
+    stats.requests = run_metrics.requests();
+    stats.rate_limited = run_metrics.rate_limited();
+    stats.index_waits = run_metrics.index_waits();
+    stats.retries = retries.retries();
+    stats.rate_limit_wait = run_metrics.waited();
+    if (cassette.is_replaying())
+        info("Replay: {} responses from `{}`, {} searches answered from its results, {} requests were not in it.",
+             cassette.replayed(), config.replay_path, cassette.searched(), cassette.missed());
+    return stats;
 }
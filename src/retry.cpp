@@ -0,0 +1,99 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/retry.hpp>
+#include <include/client.hpp>
+#include <include/ratelimit.hpp>
+#include <include/helpers.hpp>
+#include <include/logger.hpp>
+#include <nlohmann/json.hpp>
+#include <curl/curl.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <random>
+#include <string>
+
+namespace {
+    bool is_transient_error(const CURLcode result) {
+        switch (result) {
+            case CURLE_COULDNT_RESOLVE_HOST:
+            case CURLE_COULDNT_RESOLVE_PROXY:
+            case CURLE_COULDNT_CONNECT:
+            case CURLE_OPERATION_TIMEDOUT:
+            case CURLE_SSL_CONNECT_ERROR:
+            case CURLE_SEND_ERROR:
+            case CURLE_RECV_ERROR:
+            case CURLE_GOT_NOTHING:
+            case CURLE_PARTIAL_FILE:
+            case CURLE_HTTP2:
+            case CURLE_HTTP2_STREAM:
+                return true;
+            default:
+                return false;
+        }
+    }
+}
+
+Failure classify(const Response& response, const bool is_rate_limited) {
+    if (response.result == CURLE_ABORTED_BY_CALLBACK) return Failure::CANCELLED;
+    if (response.result != CURLE_OK) return is_transient_error(response.result) ? Failure::NETWORK : Failure::PERMANENT;
+    if (is_rate_limited) return Failure::RATE_LIMITED;
+    if (!is_http_error(response.http_code)) return Failure::NONE;
+    if (response.http_code >= 500) return Failure::SERVER;
+    return discord_error_code(response) ? Failure::DISCORD : Failure::PERMANENT;
+}
+
+int discord_error_code(const Response& response) {
+    if (response.body.empty()) return 0;
+    const auto body = nlohmann::json::parse(response.body, nullptr, false);
+    if (body.is_discarded() || !body.is_object() || !body.contains("code") || !body["code"].is_number_integer()) return 0;
+    return body["code"].get<int>();
+}
+
+std::string failure_reason(const Response& response) {
+    if (response.result != CURLE_OK) return curl_easy_strerror(response.result);
+    return "HTTP " + std::to_string(response.http_code);
+}
+
+RetryPolicy::RetryPolicy(RateLimiter& limiter) : limiter(limiter) {}
+
+bool RetryPolicy::should_retry(const std::string& route, const Failure failure, uint8_t& attempts) {
+    if (failure == Failure::CANCELLED) return false; // Says nothing about the route
+
+    std::scoped_lock lock(mutex);
+    if (!is_transient(failure)) {
+        if (const auto it = routes.find(route); it != routes.end()) { // Answered, so the route works again
+            if (it->second.failures >= BREAKER_FAILURES) verbose("Retry: {} is answering again.", route);
+            routes.erase(it);
+        }
+        return false;
+    }
+
+    Route& state = routes[route];
+    ++state.failures;
+    ++attempts;
+
+    // Decorrelated jitter: between the base delay and three times the last pause
+    const clock::duration base = BASE_DELAY;
+    const auto upper = std::clamp<clock::duration>(state.last_delay * 3, base, MAX_DELAY);
+    auto delay = clock::duration(std::uniform_int_distribution<clock::rep>(base.count(), upper.count())(random));
+    state.last_delay = delay;
+
+    if (state.failures >= BREAKER_FAILURES) {
+        if (state.failures == BREAKER_FAILURES)
+            verbose(WARNING, "Retry: {} failed {} times in a row, pausing it for {} s.", route, state.failures,
+                    std::chrono::duration_cast<std::chrono::seconds>(BREAKER_PAUSE).count());
+        delay = BREAKER_PAUSE; // Open until a probe gets an answer
+    }
+    limiter.pause(route, clock::now() + delay);
+
+    if (attempts >= MAX_ATTEMPTS) return false;
+    ++retry_count;
+    return true;
+}
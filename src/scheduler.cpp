@@ -0,0 +1,111 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/scheduler.hpp>
+#include <include/message.hpp>
+#include <include/filter.hpp>
+#include <include/ratelimit.hpp>
+#include <include/helpers.hpp>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include <algorithm>
+
+namespace {
+    // Bulk delete rejects messages older than two weeks. The margin covers rate limit waits and clock skew.
+    constexpr auto BULK_DELETE_MAX_AGE = std::chrono::days(14) - std::chrono::hours(1);
+}
+
+uint64_t ChannelScheduler::bulk_cutoff_ms() {
+    const auto now_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    return now_ms - std::chrono::duration_cast<std::chrono::milliseconds>(BULK_DELETE_MAX_AGE).count();
+}
+
+bool ChannelScheduler::is_bulk_deletable(const Message& message, const uint64_t cutoff_ms) {
+    return !(message.features & FEATURE_SYSTEM) && snowflake_time_ms(message.id) > cutoff_ms;
+}
+
+void ChannelScheduler::push(Message message) {
+    const auto [it, inserted] = index.try_emplace(message.channel_id, queues.size());
+    if (inserted) {
+        const std::string id = std::to_string(message.channel_id);
+        queues.push_back({{message.channel_id, channels_url + id + "/messages/", channels_url + id + "/messages/bulk-delete",
+                           "delete:" + id, "bulk:" + id}, {}, {}, {}});
+    }
+
+    Queue& queue = queues[it->second];
+    (bulk && is_bulk_deletable(message, bulk_cutoff_ms()) ? queue.recent : queue.messages).push_back(std::move(message));
+    ++count;
+}
+
+bool ChannelScheduler::is_bulk_batch(const Queue& queue, const uint64_t cutoff_ms) const {
+    return bulk && queue.channel.bulk != Channel::Bulk::DENIED && queue.singles.empty() && queue.recent.size() > 1
+        && is_bulk_deletable(queue.recent[0], cutoff_ms) && is_bulk_deletable(queue.recent[1], cutoff_ms);
+}
+
+const std::string& ChannelScheduler::next_route(const Queue& queue, const uint64_t cutoff_ms) const {
+    return is_bulk_batch(queue, cutoff_ms) ? queue.channel.bulk_route : queue.channel.delete_route;
+}
+
+Channel* ChannelScheduler::try_pop(RateLimiter& limiter, std::vector<Message>& batch) {
+    const uint64_t cutoff_ms = bulk_cutoff_ms();
+
+    for (size_t n = 0; n < queues.size(); ++n) {
+        const size_t i = (turn + n) % queues.size();
+        Queue& queue = queues[i];
+        if (queue.singles.empty() && queue.recent.empty() && queue.messages.empty()) continue;
+        if (!limiter.try_acquire(next_route(queue, cutoff_ms))) continue;
+
+        batch.clear();
+        if (is_bulk_batch(queue, cutoff_ms)) {
+            while (batch.size() < BULK_DELETE_LIMIT && !queue.recent.empty()) {
+                Message& m = queue.recent.front();
+                if (is_bulk_deletable(m, cutoff_ms)) batch.push_back(std::move(m));
+                else queue.messages.push_back(std::move(m)); // Too old by now
+                queue.recent.pop_front();
+            }
+        } else {
+            auto& from = !queue.singles.empty() ? queue.singles : !queue.messages.empty() ? queue.messages : queue.recent;
+            batch.push_back(std::move(from.front()));
+            from.pop_front();
+        }
+
+        count -= batch.size();
+        turn = i + 1;
+        return &queue.channel;
+    }
+    return nullptr;
+}
+
+void ChannelScheduler::retry(const Channel& channel, std::vector<Message>& batch, const bool singly) {
+    Queue& queue = queues[index.at(channel.id)];
+    auto& to = singly ? queue.singles : queue.recent;
+    for (auto it = batch.rbegin(); it != batch.rend(); ++it) to.push_front(std::move(*it));
+    count += batch.size();
+    batch.clear();
+}
+
+RateLimiter::clock::time_point ChannelScheduler::ready_at(RateLimiter& limiter, WaitCause* cause) const {
+    const uint64_t cutoff_ms = bulk_cutoff_ms();
+    auto earliest = RateLimiter::clock::time_point::max();
+
+    for (const Queue& queue : queues) {
+        if (queue.singles.empty() && queue.recent.empty() && queue.messages.empty()) continue;
+
+        WaitCause why;
+        if (const auto at = limiter.ready_at(next_route(queue, cutoff_ms), &why); at < earliest) {
+            earliest = at;
+            if (cause) *cause = why;
+        }
+    }
+    return earliest;
+}
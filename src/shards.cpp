@@ -0,0 +1,80 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+#include <include/shards.hpp>
+#include <include/helpers.hpp>
+#include <algorithm>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+bool ShardQueue::take(SnowflakeRange& shard, bool& is_initial) {
+    std::unique_lock lock(mutex);
+    ++waiting;
+    changed.wait(lock, [this] { return is_stopped || !pending.empty() || active == 0; });
+    --waiting;
+
+    if (is_stopped || pending.empty()) { // Nothing left that could still be split
+        changed.notify_all();
+        return false;
+    }
+
+    shard = pending.front();
+    pending.pop_front();
+    is_initial = initial > 0;
+    if (initial) --initial;
+    ++active;
+    return true;
+}
+
+void ShardQueue::split(SnowflakeRange& rest, const uint64_t total_results) {
+    constexpr uint64_t MIN_SPAN = MIN_SPAN_MS << 22; // Snowflakes count milliseconds from bit 22 up
+
+    std::scoped_lock lock(mutex);
+    if (total_results <= SPLIT_RESULTS || waiting <= pending.size() || rest.max_id - rest.min_id < 2 * MIN_SPAN) return;
+
+    // (min, middle] goes to the idle worker, this one goes on with (middle, max)
+    const uint64_t middle = rest.min_id + (rest.max_id - rest.min_id) / 2;
+    pending.push_back({rest.min_id, middle + 1});
+    rest.min_id = middle;
+    changed.notify_one();
+}
+
+void ShardQueue::finish() {
+    std::scoped_lock lock(mutex);
+    --active;
+    changed.notify_all();
+}
+
+void ShardQueue::stop() {
+    std::scoped_lock lock(mutex);
+    is_stopped = true;
+    changed.notify_all();
+}
+
+bool ShardQueue::is_stopping() {
+    std::scoped_lock lock(mutex);
+    return is_stopped;
+}
+
+std::vector<SnowflakeRange> subtract_ranges(const SnowflakeRange& range, std::vector<SnowflakeRange> searched) {
+    // Worked on inclusive bounds, [min_id + 1, max_id - 1]
+    std::ranges::sort(searched, {}, &SnowflakeRange::min_id);
+    std::vector<SnowflakeRange> left;
+    uint64_t next = range.min_id + 1;
+    const uint64_t last = range.max_id - 1;
+
+    for (const auto& s : searched) {
+        if (next > last) break;
+        if (s.max_id - 1 < next) continue; // Entirely below what is left
+        if (s.min_id + 1 > next) left.push_back({next - 1, std::min(s.min_id + 1, last + 1)});
+        next = std::max(next, s.max_id);
+    }
+    if (next <= last) left.push_back({next - 1, last + 1});
+    return left;
+}
@@ -0,0 +1,95 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+/*
+ * Checks of `ArchiveWriter` and `find_archived`: records written in the background, appended to and read back.
+ * Exits with a non-zero status on the first failed check.
+ */
+
+#include <include/archive.hpp>
+#include <zlib.h>
+#include <filesystem>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    constexpr uint64_t RECORD_COUNT = 3000; // About 300 KiB, more than one member
+
+    void check(const bool condition, const char* what) {
+        if (condition) return;
+        std::fprintf(stderr, "Failed: %s\n", what);
+        std::exit(EXIT_FAILURE);
+    }
+
+    std::string record(const uint64_t id, const std::string& content) {
+        return R"({"id": ")" + std::to_string(id) + R"(", "content": ")" + content + R"(", "padding": "................................"})";
+    }
+
+    // Lines of the whole archive, read as one gzip stream like `zcat` does
+    uint64_t count_lines(const std::string& path) {
+        gzFile in = gzopen(path.c_str(), "rb");
+        check(in != nullptr, "the archive opens as gzip");
+
+        uint64_t lines = 0;
+        char buffer[64 * 1024];
+        int read;
+        while ((read = gzread(in, buffer, sizeof(buffer))) > 0)
+            for (int i = 0; i < read; ++i) lines += buffer[i] == '\n';
+        check(read == 0, "the archive decompresses to the end");
+        gzclose(in);
+        return lines;
+    }
+}
+
+int main() {
+    const std::string path = (std::filesystem::temp_directory_path() / "discord-rm-archive-test.gz").string();
+    std::filesystem::remove(path);
+    std::filesystem::remove(path + ".idx");
+
+    bool is_refused = false;
+    try {
+        find_archived(path, 1);
+    } catch (const std::invalid_argument&) {
+        is_refused = true;
+    }
+    check(is_refused, "an archive without an index is refused");
+
+    {
+        ArchiveWriter archive(path);
+        uint64_t sequence = 0;
+        for (uint64_t id = 1; id <= RECORD_COUNT / 2; ++id) sequence = archive.add(id, record(id, "first"));
+        archive.wait(sequence);
+        check(std::filesystem::file_size(path) > 0, "waited records are written");
+
+        for (uint64_t id = RECORD_COUNT / 2 + 1; id <= RECORD_COUNT; ++id) archive.add(id, record(id, "first"));
+    } // The rest is written by the destructor
+
+    check(count_lines(path) == RECORD_COUNT, "every record is archived once");
+    check(find_archived(path, 1) == record(1, "first"), "finds the first record");
+    check(find_archived(path, RECORD_COUNT / 2) == record(RECORD_COUNT / 2, "first"), "finds a waited record");
+    check(find_archived(path, RECORD_COUNT) == record(RECORD_COUNT, "first"), "finds a record written by the destructor");
+    check(!find_archived(path, RECORD_COUNT + 1), "a message that was not archived is not found");
+
+    {
+        ArchiveWriter archive(path); // Appended to, like a resumed run
+        archive.wait(archive.add(7, record(7, "second")));
+        archive.add(RECORD_COUNT + 1, record(RECORD_COUNT + 1, "second"));
+    }
+
+    check(count_lines(path) == RECORD_COUNT + 2, "appended members follow the existing ones");
+    check(find_archived(path, 7) == record(7, "second"), "the last record of a message archived twice wins");
+    check(find_archived(path, 8) == record(8, "first"), "records before an appended run are still found");
+    check(find_archived(path, RECORD_COUNT + 1) == record(RECORD_COUNT + 1, "second"), "finds an appended record");
+
+    std::filesystem::remove(path);
+    std::filesystem::remove(path + ".idx");
+    return EXIT_SUCCESS;
+}
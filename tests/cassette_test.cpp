@@ -0,0 +1,151 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+/*
+ * Checks of `Cassette`: which recorded response a replayed request gets.
+ * Exits with a non-zero status on the first failed check.
+ */
+
+#include <include/cassette.hpp>
+#include <include/client.hpp>
+#include <include/config.hpp>
+#include <nlohmann/json.hpp>
+#include <filesystem>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+    const std::string RECORDED_API = "https://discord.test/api";
+    const std::string REPLAYED_API = "http://localhost:8080/api";
+    const std::string SEARCH = "/guilds/1/messages/search?author_id=7&include_nsfw=true";
+    const std::string BULK_DELETE = "/channels/42/messages/bulk-delete";
+
+    void check(const bool condition, const char* what) {
+        if (condition) return;
+        std::fprintf(stderr, "Failed: %s\n", what);
+        std::exit(EXIT_FAILURE);
+    }
+
+    Response answer(const long http_code, const std::string& body = {}) {
+        Response response;
+        response.http_code = http_code;
+        response.body = body;
+        return response;
+    }
+
+    // A search page with the given message IDs, newest first
+    std::string page(const std::vector<uint64_t>& ids) {
+        nlohmann::json messages = nlohmann::json::array();
+        for (const uint64_t id : ids) messages.push_back({{{"id", std::to_string(id)}, {"channel_id", "42"}}});
+        return nlohmann::json{{"total_results", ids.size()}, {"messages", messages}}.dump();
+    }
+
+    // IDs of the results of a replayed search page, and its total
+    std::vector<uint64_t> results(const Response& response, uint64_t& total) {
+        const auto body = nlohmann::json::parse(response.body);
+        total = body.at("total_results").get<uint64_t>();
+        std::vector<uint64_t> ids;
+        for (const auto& group : body.at("messages")) ids.push_back(std::stoull(group.at(0).at("id").get<std::string>()));
+        return ids;
+    }
+
+    void record(const std::string& dir) {
+        Cassette cassette;
+        cassette.record_to(dir, RECORDED_API);
+
+        cassette.record("GET", RECORDED_API + "/users/@me", "", answer(200, R"({"id": "7", "call": 1})"));
+        cassette.record("GET", RECORDED_API + "/users/@me", "", answer(200, R"({"id": "7", "call": 2})"));
+
+        cassette.record("POST", RECORDED_API + BULK_DELETE, R"({"messages":["10","11"]})", answer(204));
+        cassette.record("POST", RECORDED_API + BULK_DELETE, R"({"messages":["12","13"]})", answer(400, R"({"code": 50034})"));
+
+        Response limited = answer(429, R"({"retry_after": 2.5, "global": false})");
+        limited.headers = {{"x-ratelimit-bucket", "abc"}, {"x-ratelimit-reset-after", "2.5"}, {"retry-after", "3"}};
+        cassette.record("DELETE", RECORDED_API + "/channels/42/messages/20", "", limited);
+
+        // Two shards that overlap at 300, see `ShardQueue`
+        cassette.record("GET", RECORDED_API + SEARCH + "&min_id=100&max_id=400", "", answer(200, page({300, 200})));
+        cassette.record("GET", RECORDED_API + SEARCH + "&min_id=250&max_id=600", "", answer(200, page({500, 300})));
+    }
+
+    void check_replay(const std::string& dir) {
+        Cassette cassette;
+        cassette.replay_from(dir, REPLAYED_API, false);
+        check(cassette.is_replaying() && !cassette.is_fast(), "replays at recorded speed");
+
+        // Repeated requests get the recorded responses in order, whatever the API URL
+        check(cassette.replay("GET", REPLAYED_API + "/users/@me", "").body == R"({"id": "7", "call": 1})", "first of a repeated request");
+        check(cassette.replay("GET", REPLAYED_API + "/users/@me", "").body == R"({"id": "7", "call": 2})", "second of a repeated request");
+        check(cassette.replay("GET", REPLAYED_API + "/users/@me", "").http_code == 404, "a request replayed more often than recorded");
+
+        // Bodies are matched first, then the next exchange of the route is taken
+        check(cassette.replay("POST", REPLAYED_API + BULK_DELETE, R"({"messages":["12","13"]})").http_code == 400, "matched by body");
+        check(cassette.replay("POST", REPLAYED_API + BULK_DELETE, R"({"messages":["10"]})").http_code == 204, "a batch cut differently");
+
+        const Response limited = cassette.replay("DELETE", REPLAYED_API + "/channels/42/messages/20", "");
+        check(limited.http_code == 429 && limited.header("retry-after") == "3", "recorded waits are kept");
+        check(limited.header("x-ratelimit-bucket") == "abc", "recorded headers are replayed");
+
+        // A recorded search is replayed as it was
+        uint64_t total = 0;
+        auto ids = results(cassette.replay("GET", REPLAYED_API + SEARCH + "&min_id=100&max_id=400", ""), total);
+        check(ids == std::vector<uint64_t>{300, 200} && total == 2, "a recorded search");
+
+        // A shard split differently is answered from every recorded result, without duplicates
+        ids = results(cassette.replay("GET", REPLAYED_API + SEARCH + "&min_id=150&max_id=550", ""), total);
+        check(ids == std::vector<uint64_t>{500, 300, 200} && total == 3, "a search that was not recorded");
+        ids = results(cassette.replay("GET", REPLAYED_API + SEARCH + "&min_id=300&max_id=500", ""), total);
+        check(ids.empty() && total == 0, "the range of a search is exclusive");
+        ids = results(cassette.replay("GET", REPLAYED_API + SEARCH + "&min_id=100&max_id=400", ""), total);
+        check(ids == std::vector<uint64_t>{300, 200}, "a recorded search replayed again");
+
+        check(cassette.replay("GET", REPLAYED_API + "/guilds/1/messages/search?author_id=8", "").http_code == 404,
+              "a search with other parameters");
+        check(cassette.replay("DELETE", REPLAYED_API + "/channels/42/messages/21", "").http_code == 404, "a request that was not recorded");
+
+        check(cassette.replayed() == 6, "replayed exchanges are counted");
+        check(cassette.searched() == 3, "searches answered from the results are counted");
+        check(cassette.missed() == 3, "misses are counted");
+    }
+
+    void check_fast_replay(const std::string& dir) {
+        Cassette cassette;
+        cassette.replay_from(dir, RECORDED_API, true);
+        check(cassette.is_fast(), "replays fast");
+
+        const Response limited = cassette.replay("DELETE", RECORDED_API + "/channels/42/messages/20", "");
+        check(limited.http_code == 429, "the rate limit is still replayed");
+        check(limited.header("retry-after") == "0" && limited.header("x-ratelimit-reset-after") == "0", "the header waits are cleared");
+        check(nlohmann::json::parse(limited.body).at("retry_after") == 0, "the body wait is cleared");
+    }
+}
+
+int main() {
+    const std::string dir = (std::filesystem::temp_directory_path() / "discord-rm-cassette-test").string();
+    std::filesystem::remove_all(dir);
+
+    bool is_refused = false;
+    try {
+        Cassette cassette;
+        cassette.replay_from(dir, RECORDED_API, false);
+    } catch (const std::invalid_argument&) {
+        is_refused = true;
+    }
+    check(is_refused, "a missing recording is refused");
+
+    record(dir);
+    check_replay(dir);
+    check_fast_replay(dir);
+
+    std::filesystem::remove_all(dir);
+    return EXIT_SUCCESS;
+}
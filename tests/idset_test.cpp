@@ -0,0 +1,58 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+/*
+ * Checks of `IdSet`: probing past occupied slots, and growing without losing IDs.
+ * Exits with a non-zero status on the first failed check.
+ */
+
+#include <include/idset.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+    void check(const bool condition, const char* what) {
+        if (condition) return;
+        std::fprintf(stderr, "Failed: %s\n", what);
+        std::exit(EXIT_FAILURE);
+    }
+
+    // A snowflake of the given millisecond, with zero worker, process and sequence bits like most real ones
+    uint64_t snowflake(const uint64_t ms) { return ms << 22; }
+}
+
+int main() {
+    IdSet empty;
+    check(empty.empty() && !empty.contains(snowflake(1)), "an empty set contains nothing");
+
+    IdSet set;
+    check(set.insert(snowflake(1)), "insert takes a new ID");
+    check(!set.insert(snowflake(1)), "insert refuses an ID already in the set");
+    check(set.size() == 1 && set.contains(snowflake(1)), "the set has the inserted ID");
+
+    // Far more than the first table holds, so it grows several times and many IDs share a slot before probing
+    constexpr uint64_t COUNT = 100'000;
+    for (uint64_t ms = 2; ms <= COUNT; ++ms) set.insert(snowflake(ms));
+    check(set.size() == COUNT, "the set counts every ID once");
+
+    bool is_complete = true;
+    for (uint64_t ms = 1; ms <= COUNT; ++ms) is_complete &= set.contains(snowflake(ms));
+    check(is_complete, "growing keeps every ID");
+
+    bool is_exact = true;
+    for (uint64_t ms = COUNT + 1; ms <= 2 * COUNT; ++ms) is_exact &= !set.contains(snowflake(ms));
+    for (uint64_t ms = 1; ms <= COUNT; ++ms) is_exact &= !set.contains(snowflake(ms) + 1); // Neighbours of inserted IDs
+    check(is_exact, "probing stops at an empty slot without finding IDs that were not inserted");
+
+    bool is_refused = true;
+    for (uint64_t ms = 1; ms <= COUNT; ++ms) is_refused &= !set.insert(snowflake(ms));
+    check(is_refused && set.size() == COUNT, "after growing, insert still finds every ID it has");
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,76 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+/*
+ * Checks of the checkpoint journal: what a resumed run takes from it, and which journals it refuses.
+ * Exits with a non-zero status on the first failed check.
+ */
+
+#include <include/journal.hpp>
+#include <filesystem>
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+
+namespace {
+    void check(const bool condition, const char* what) {
+        if (condition) return;
+        std::fprintf(stderr, "Failed: %s\n", what);
+        std::exit(EXIT_FAILURE);
+    }
+}
+
+int main() {
+    const std::string path = (std::filesystem::temp_directory_path() / "discord-rm-journal-test.journal").string();
+    const std::string header = "123 456 789";
+
+    {
+        Journal journal(path, false, header);
+        journal.page({10, 100});
+        journal.queued(50);
+        journal.deleted(50);
+        journal.skipped(60);
+    }
+
+    {
+        Journal journal(path, true, header);
+        const auto& state = journal.state();
+        check(state.done.contains(50) && state.done.contains(60), "resume keeps the deleted and skipped messages");
+        check(state.deleted.size() == 1 && state.deleted[0] == 50, "resume keeps the deleted messages as tombstones");
+        check(state.searched.size() == 1 && state.searched[0].min_id == 10 && state.searched[0].max_id == 100, "resume keeps the searched page");
+    }
+
+    {
+        Journal journal(path, true, header);
+        journal.page({100, 200});
+        journal.queued(150); // Interrupted before it was deleted
+        journal.page({200, 300});
+        journal.queued(250);
+        journal.failed(250, "Internal Server Error");
+    }
+
+    {
+        Journal journal(path, true, header);
+        const auto& state = journal.state();
+        check(state.searched.size() == 1 && state.searched[0].min_id == 10, "resume searches the pages with an unfinished or failed message again");
+        check(!state.done.contains(150), "resume deletes an unfinished message again");
+        check(!state.done.contains(250), "resume deletes a failed message again");
+    }
+
+    bool is_refused = false;
+    try {
+        Journal journal(path, true, "123 456 000");
+    } catch (const std::invalid_argument&) {
+        is_refused = true;
+    }
+    check(is_refused, "resume refuses the journal of a different sender");
+
+    std::filesystem::remove(path);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+/*
+ * Checks of `classify` and `RetryPolicy`: how many times a request is sent, and when the circuit of a route opens and closes.
+ * Exits with a non-zero status on the first failed check.
+ */
+
+#include <include/retry.hpp>
+#include <include/ratelimit.hpp>
+#include <include/client.hpp>
+#include <curl/curl.h>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+    const std::string ROUTE = "DELETE /channels/42/messages";
+
+    void check(const bool condition, const char* what) {
+        if (condition) return;
+        std::fprintf(stderr, "Failed: %s\n", what);
+        std::exit(EXIT_FAILURE);
+    }
+
+    Response answered(const long http_code, const std::string& body = {}) {
+        Response response;
+        response.http_code = http_code;
+        response.body = body;
+        return response;
+    }
+
+    Response failed(const CURLcode result) {
+        Response response;
+        response.result = result;
+        return response;
+    }
+
+    // Records `count` failures of separate requests on the route
+    void fail(RetryPolicy& retries, const uint32_t count, const Failure failure = Failure::SERVER) {
+        for (uint32_t i = 0; i < count; ++i) {
+            uint8_t attempts = 0;
+            retries.should_retry(ROUTE, failure, attempts);
+        }
+    }
+
+    void check_classify() {
+        check(classify(answered(200), false) == Failure::NONE, "2xx is not a failure");
+        check(classify(answered(204), false) == Failure::NONE, "204 is not a failure");
+        check(classify(answered(429), true) == Failure::RATE_LIMITED, "rate limited answers are waited out");
+        check(classify(answered(202), true) == Failure::RATE_LIMITED, "search index waits are waited out");
+        check(classify(answered(503), false) == Failure::SERVER, "5xx is a server failure");
+        check(classify(answered(404, R"({"message": "Unknown Message", "code": 10008})"), false) == Failure::DISCORD,
+              "4xx with a Discord error code");
+        check(classify(answered(404), false) == Failure::PERMANENT, "4xx without a body is permanent");
+        check(classify(answered(400, "not json"), false) == Failure::PERMANENT, "4xx with an unreadable body is permanent");
+        check(classify(failed(CURLE_COULDNT_CONNECT), false) == Failure::NETWORK, "refused connections are transient");
+        check(classify(failed(CURLE_OPERATION_TIMEDOUT), false) == Failure::NETWORK, "timeouts are transient");
+        check(classify(failed(CURLE_URL_MALFORMAT), false) == Failure::PERMANENT, "a malformed URL is permanent");
+        check(classify(failed(CURLE_ABORTED_BY_CALLBACK), false) == Failure::CANCELLED, "aborted transfers are cancelled");
+    }
+
+    void check_attempts() {
+        RateLimiter limiter;
+        RetryPolicy retries(limiter);
+
+        uint8_t attempts = 0;
+        for (uint8_t i = 1; i < RetryPolicy::MAX_ATTEMPTS; ++i)
+            check(retries.should_retry(ROUTE, Failure::NETWORK, attempts), "transient failures are retried");
+        check(!retries.should_retry(ROUTE, Failure::SERVER, attempts), "no retry after the last attempt");
+        check(attempts == RetryPolicy::MAX_ATTEMPTS, "every failed attempt is counted");
+        check(retries.retries() == RetryPolicy::MAX_ATTEMPTS - 1, "retries exclude the first attempt");
+
+        for (const Failure failure : {Failure::NONE, Failure::RATE_LIMITED, Failure::DISCORD, Failure::PERMANENT, Failure::CANCELLED}) {
+            uint8_t other = 0;
+            check(!retries.should_retry(ROUTE, failure, other), "only transient failures are retried");
+            check(other == 0, "other failures are not counted as attempts");
+        }
+        check(retries.retries() == RetryPolicy::MAX_ATTEMPTS - 1, "retries are unchanged by other failures");
+    }
+
+    void check_pause() {
+        RateLimiter limiter;
+        RetryPolicy retries(limiter);
+
+        const auto before = RateLimiter::clock::now();
+        fail(retries, 1);
+        WaitCause cause;
+        const auto ready = limiter.ready_at(ROUTE, &cause);
+        check(ready >= before + RetryPolicy::BASE_DELAY, "a transient failure pauses the route");
+        check(ready <= RateLimiter::clock::now() + RetryPolicy::MAX_DELAY, "the pause is capped");
+        check(cause == WaitCause::BACKOFF, "the pause is waited for as a backoff");
+    }
+
+    void check_breaker() {
+        RateLimiter limiter;
+        RetryPolicy retries(limiter);
+
+        fail(retries, RetryPolicy::BREAKER_FAILURES - 1);
+        check(limiter.ready_at(ROUTE) <= RateLimiter::clock::now() + RetryPolicy::MAX_DELAY, "closed below the failure count");
+
+        const auto before = RateLimiter::clock::now();
+        fail(retries, 1);
+        check(limiter.ready_at(ROUTE) >= before + RetryPolicy::BREAKER_PAUSE, "opens after the failure count");
+    }
+
+    void check_breaker_reset() {
+        // Failures with an answer in between are not in a row
+        RateLimiter answered_limiter;
+        RetryPolicy answered_retries(answered_limiter);
+        fail(answered_retries, RetryPolicy::BREAKER_FAILURES - 1);
+        fail(answered_retries, 1, Failure::NONE);
+        fail(answered_retries, RetryPolicy::BREAKER_FAILURES - 1);
+        check(answered_limiter.ready_at(ROUTE) <= RateLimiter::clock::now() + RetryPolicy::MAX_DELAY, "an answer closes the circuit");
+
+        // A cancelled request says nothing about the route
+        RateLimiter cancelled_limiter;
+        RetryPolicy cancelled_retries(cancelled_limiter);
+        fail(cancelled_retries, RetryPolicy::BREAKER_FAILURES - 1);
+        fail(cancelled_retries, 1, Failure::CANCELLED);
+        const auto before = RateLimiter::clock::now();
+        fail(cancelled_retries, 1);
+        check(cancelled_limiter.ready_at(ROUTE) >= before + RetryPolicy::BREAKER_PAUSE, "a cancelled request keeps the failures");
+
+        // Other routes are not paused
+        check(cancelled_limiter.ready_at("GET /channels/42/messages/search") <= RateLimiter::clock::now(), "routes are paused apart");
+    }
+}
+
+int main() {
+    check_classify();
+    check_attempts();
+    check_pause();
+    check_breaker();
+    check_breaker_reset();
+    return EXIT_SUCCESS;
+}
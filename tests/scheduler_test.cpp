@@ -0,0 +1,114 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+/*
+ * Checks of `ChannelScheduler`: which messages go into bulk delete batches, close to the 14 day cutoff.
+ * Exits with a non-zero status on the first failed check.
+ */
+
+#include <include/scheduler.hpp>
+#include <include/ratelimit.hpp>
+#include <include/message.hpp>
+#include <include/filter.hpp>
+#include <include/helpers.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+    constexpr uint64_t CHANNEL_ID = 42;
+    constexpr uint64_t MINUTE_MS = 60 * 1000;
+
+    void check(const bool condition, const char* what) {
+        if (condition) return;
+        std::fprintf(stderr, "Failed: %s\n", what);
+        std::exit(EXIT_FAILURE);
+    }
+
+    // A message sent at the given Unix time in milliseconds, `sequence` keeps the IDs apart
+    Message message_at(const uint64_t unix_ms, const uint64_t sequence = 0, const FeatureSet features = 0) {
+        Message message;
+        message.id = ((unix_ms - DISCORD_EPOCH) << 22) | sequence;
+        message.channel_id = CHANNEL_ID;
+        message.features = features;
+        return message;
+    }
+
+    // Every pop with a limiter of its own, so only the scheduler decides what is handed out
+    std::vector<Message> pop(ChannelScheduler& scheduler) {
+        RateLimiter limiter;
+        std::vector<Message> batch;
+        const Channel* channel = scheduler.try_pop(limiter, batch);
+        check(channel && channel->id == CHANNEL_ID, "a queued channel is handed out");
+        return batch;
+    }
+}
+
+int main() {
+    const uint64_t cutoff_ms = ChannelScheduler::bulk_cutoff_ms();
+    const uint64_t now_ms = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    check(cutoff_ms < now_ms - 13 * 24 * 60 * MINUTE_MS && cutoff_ms > now_ms - 14 * 24 * 60 * MINUTE_MS,
+          "the cutoff is a bit less than 14 days ago");
+
+    check(!ChannelScheduler::is_bulk_deletable(message_at(cutoff_ms), cutoff_ms), "a message at the cutoff is too old");
+    check(ChannelScheduler::is_bulk_deletable(message_at(cutoff_ms + 1), cutoff_ms), "a message just after the cutoff is young enough");
+    check(!ChannelScheduler::is_bulk_deletable(message_at(cutoff_ms + 1, 0, FEATURE_SYSTEM), cutoff_ms), "a system message is never bulk deleted");
+
+    {
+        // Shards are searched side by side, so old and recent messages of a channel arrive mixed
+        ChannelScheduler scheduler("https://discord.test/channels/", true);
+        scheduler.push(message_at(cutoff_ms - MINUTE_MS));
+        for (uint64_t i = 0; i < 5; ++i) scheduler.push(message_at(cutoff_ms + 10 * MINUTE_MS, i));
+        scheduler.push(message_at(cutoff_ms - 2 * MINUTE_MS));
+        scheduler.push(message_at(cutoff_ms + 10 * MINUTE_MS, 9, FEATURE_SYSTEM));
+        check(scheduler.size() == 8, "every pushed message is queued");
+
+        const auto batch = pop(scheduler);
+        bool is_recent = batch.size() == 5;
+        for (const auto& m : batch) is_recent &= ChannelScheduler::is_bulk_deletable(m, cutoff_ms);
+        check(is_recent, "the recent messages are batched, whatever is queued before them");
+
+        for (int i = 0; i < 3; ++i) check(pop(scheduler).size() == 1, "old and system messages are deleted one by one");
+        check(scheduler.empty(), "every message is handed out once");
+    }
+
+    {
+        ChannelScheduler scheduler("https://discord.test/channels/", true);
+        scheduler.push(message_at(cutoff_ms + MINUTE_MS));
+        scheduler.push(message_at(cutoff_ms - MINUTE_MS));
+        check(pop(scheduler).size() == 1 && pop(scheduler).size() == 1, "a single recent message is not a batch");
+    }
+
+    {
+        ChannelScheduler scheduler("https://discord.test/channels/", true);
+        for (uint64_t i = 0; i < ChannelScheduler::BULK_DELETE_LIMIT + 10; ++i) scheduler.push(message_at(cutoff_ms + MINUTE_MS, i));
+
+        check(pop(scheduler).size() == ChannelScheduler::BULK_DELETE_LIMIT, "a batch has at most BULK_DELETE_LIMIT messages");
+        check(pop(scheduler).size() == 10, "the rest is the next batch");
+
+        RateLimiter limiter;
+        std::vector<Message> refused;
+        scheduler.push(message_at(cutoff_ms + MINUTE_MS, 200));
+        scheduler.push(message_at(cutoff_ms + MINUTE_MS, 201));
+        const Channel* channel = scheduler.try_pop(limiter, refused);
+        check(channel && refused.size() == 2, "a new pair is batched");
+        scheduler.retry(*channel, refused, true);
+        check(pop(scheduler).size() == 1 && pop(scheduler).size() == 1, "a refused batch is retried one by one");
+    }
+
+    {
+        ChannelScheduler scheduler("https://discord.test/channels/", false);
+        for (uint64_t i = 0; i < 3; ++i) scheduler.push(message_at(cutoff_ms + MINUTE_MS, i));
+        check(pop(scheduler).size() == 1, "without bulk, recent messages are deleted one by one");
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,131 @@
+/*
+ * DISCORD-RM
+ * --------------------------------
+ * CLI removal tool for Discord chats,
+ * using an authorization token and
+ * the Discord API.
+ */
+
+/*
+ * Checks of the time shards: where `ShardQueue::split` cuts a shard, when it does not,
+ * and what `subtract_ranges` leaves of a range. All bounds are exclusive.
+ * Exits with a non-zero status on the first failed check.
+ */
+
+#include <include/shards.hpp>
+#include <include/helpers.hpp>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+    constexpr uint64_t HOUR = ShardQueue::MIN_SPAN_MS << 22; // One hour of snowflakes
+    constexpr uint64_t MANY_RESULTS = ShardQueue::SPLIT_RESULTS + 1;
+
+    void check(const bool condition, const char* what) {
+        if (condition) return;
+        std::fprintf(stderr, "Failed: %s\n", what);
+        std::exit(EXIT_FAILURE);
+    }
+
+    bool operator==(const SnowflakeRange& a, const SnowflakeRange& b) { return a.min_id == b.min_id && a.max_id == b.max_id; }
+
+    bool is_equal(const std::vector<SnowflakeRange>& ranges, const std::vector<SnowflakeRange>& expected) {
+        if (ranges.size() != expected.size()) return false;
+        for (size_t i = 0; i < ranges.size(); ++i)
+            if (!(ranges[i] == expected[i])) return false;
+        return true;
+    }
+
+    void check_split() {
+        const SnowflakeRange whole{1000, 1000 + 4 * HOUR};
+        ShardQueue shards({whole});
+
+        SnowflakeRange rest;
+        bool is_initial = false;
+        check(shards.take(rest, is_initial) && is_initial && rest == whole, "the first worker takes the initial shard");
+
+        shards.split(rest, MANY_RESULTS);
+        check(rest == whole, "nothing is split off without an idle worker");
+
+        SnowflakeRange other;
+        bool has_other = false, has_more = true;
+        std::thread idle([&] {
+            bool is_split_initial = true;
+            has_other = shards.take(other, is_split_initial) && !is_split_initial;
+            shards.finish();
+            has_more = shards.take(other, is_split_initial);
+        });
+
+        // The idle worker is waiting once a split goes through; before that, split leaves the shard alone
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        shards.split(rest, ShardQueue::SPLIT_RESULTS);
+        check(rest == whole, "a shard with few results left is not split");
+        while (rest == whole && std::chrono::steady_clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            shards.split(rest, MANY_RESULTS);
+        }
+
+        check(rest.max_id == whole.max_id && rest.min_id > whole.min_id, "the worker keeps the newer half");
+        shards.finish();
+        idle.join();
+
+        check(has_other && other.min_id == whole.min_id, "the idle worker gets the older half");
+        check(other.max_id == rest.min_id + 1, "the halves meet without a gap or an overlap");
+        check(rest.max_id - rest.min_id == 2 * HOUR, "the shard is cut in the middle");
+        check(!has_more, "take returns false once every shard is searched");
+    }
+
+    void check_min_span() {
+        const SnowflakeRange short_shard{0, 2 * HOUR - 1};
+        ShardQueue shards({short_shard});
+
+        SnowflakeRange rest;
+        bool is_initial = false;
+        shards.take(rest, is_initial);
+
+        bool has_other = true;
+        std::thread idle([&] {
+            SnowflakeRange other;
+            bool is_other_initial = false;
+            has_other = shards.take(other, is_other_initial);
+        });
+
+        // Each half would be shorter than an hour
+        for (int i = 0; i < 50; ++i) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            shards.split(rest, MANY_RESULTS);
+        }
+        check(rest == short_shard, "a shard shorter than two hours is not split");
+
+        shards.finish();
+        idle.join();
+        check(!has_other, "nothing was split off the short shard");
+    }
+
+    void check_subtract() {
+        const SnowflakeRange range{10, 40};
+
+        check(is_equal(subtract_ranges(range, {}), {range}), "nothing searched leaves the whole range");
+        check(subtract_ranges(range, {range}).empty(), "the range itself leaves nothing");
+        check(subtract_ranges(range, {{0, 100}}).empty(), "a wider range leaves nothing");
+        check(is_equal(subtract_ranges(range, {{20, 30}}), {{10, 21}, {29, 40}}), "a range in the middle leaves both sides, bounds included");
+
+        // Pages of a walk share their bounds: (24, 40) holds 25..39 and (10, 25) holds 11..24
+        check(subtract_ranges(range, {{24, 40}, {10, 25}}).empty(), "adjacent pages leave nothing between them");
+        check(is_equal(subtract_ranges(range, {{25, 40}, {10, 25}}), {{24, 26}}), "the bound of two pages that do not share it is left");
+
+        check(is_equal(subtract_ranges(range, {{30, 50}, {0, 15}}), {{14, 31}}), "unsorted ranges that stick out are clipped");
+        check(is_equal(subtract_ranges(range, {{10, 11}, {39, 40}}), {range}), "empty ranges leave everything");
+    }
+}
+
+int main() {
+    check_split();
+    check_min_span();
+    check_subtract();
+    return EXIT_SUCCESS;
+}